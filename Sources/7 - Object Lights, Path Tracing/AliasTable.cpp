@@ -0,0 +1,87 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#include "AliasTable.h"
+
+#include "Math.h"
+
+void AliasTable::Build(const std::vector<float> &weights)
+{
+    size_t cellCount = weights.size();
+    cells.resize(cellCount);
+
+    double weightSum = 0.0;
+
+    for(float weight : weights)
+    {
+        weightSum += weight;
+    }
+
+    if(cellCount == 0 || weightSum <= 0.0)
+    {
+        cells.clear();
+        return;
+    }
+
+    // Scaled so that the mean weight is one, cells under one are filled up from the cells over one
+    std::vector<double> scaledWeights(cellCount);
+    std::vector<unsigned int> under, over;
+
+    for(size_t cellIndex = 0; cellIndex < cellCount; cellIndex++)
+    {
+        scaledWeights[cellIndex] = weights[cellIndex] * cellCount / weightSum;
+
+        if(scaledWeights[cellIndex] < 1.0) under.push_back(cellIndex);
+        else over.push_back(cellIndex);
+    }
+
+    while(!under.empty() && !over.empty())
+    {
+        unsigned int underIndex = under.back();
+        unsigned int overIndex = over.back();
+        under.pop_back();
+        over.pop_back();
+
+        cells[underIndex].probability = (float)scaledWeights[underIndex];
+        cells[underIndex].alias = overIndex;
+
+        scaledWeights[overIndex] -= 1.0 - scaledWeights[underIndex];
+
+        if(scaledWeights[overIndex] < 1.0) under.push_back(overIndex);
+        else over.push_back(overIndex);
+    }
+
+    // What is left is one up to rounding
+    for(unsigned int cellIndex : under)
+    {
+        cells[cellIndex].probability = 1.f;
+        cells[cellIndex].alias = cellIndex;
+    }
+
+    for(unsigned int cellIndex : over)
+    {
+        cells[cellIndex].probability = 1.f;
+        cells[cellIndex].alias = cellIndex;
+    }
+}
+
+unsigned int AliasTable::Sample(float u, float &remappedU) const
+{
+    float scaledU = u * cells.size();
+    unsigned int cellIndex = mathMin((unsigned int)scaledU, (unsigned int)cells.size() - 1);
+    float cellU = mathMin(scaledU - cellIndex, 1.f);
+
+    const Cell &cell = cells[cellIndex];
+
+    if(cellU < cell.probability || cell.probability >= 1.f)
+    {
+        remappedU = mathMin(cellU / cell.probability, 1.f);
+        return cellIndex;
+    }
+
+    remappedU = mathMin((cellU - cell.probability) / (1.f - cell.probability), 1.f);
+    return cell.alias;
+}
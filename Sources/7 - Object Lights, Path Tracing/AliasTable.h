@@ -0,0 +1,41 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#ifndef __ALIASTABLE_H__
+#define __ALIASTABLE_H__
+
+#include <vector>
+
+/*
+    Walker's alias table
+    Picks an index proportional to its weight in constant time, each cell keeps its own index or hands over to its alias
+*/
+class AliasTable
+{
+public:
+    // Builds the table over the weights, the weights do not have to be normalized
+    void Build(const std::vector<float> &weights);
+
+    // Maps u in [0, 1) to an index, remappedU is the uniform remainder of u that can be reused
+    unsigned int Sample(float u, float &remappedU) const;
+
+    inline bool IsEmpty() const
+    {
+        return cells.empty();
+    }
+
+private:
+    struct Cell
+    {
+        // Probability of keeping the cell's own index
+        float probability;
+        unsigned int alias;
+    };
+
+    std::vector<Cell> cells;
+};
+
+#endif
@@ -16,6 +16,12 @@ Vector3 AreaLight::GetPosition() const
     return position + edgeVectorU * randomU + edgeVectorV * randomV;
 }
 
+Vector3 AreaLight::SamplePosition(float u, float v, Vector3 &lightNormal) const
+{
+    lightNormal = this->lightNormal;
+    return position + edgeVectorU * u + edgeVectorV * v;
+}
+
 Vector3 AreaLight::GetIntensityAtPosition(const Vector3& lightPosition, const Vector3& positionAt) const
 {
     Vector3 l = lightPosition - positionAt;
@@ -25,3 +31,19 @@ Vector3 AreaLight::GetIntensityAtPosition(const Vector3& lightPosition, const Ve
 
     return (intensity * Vector3::Dot(l.GetNormalized(), lightNormal)) / (distance * distance);
 }
+
+// The intensity falls off with the cosine to the normal on both sides
+bool AreaLight::GetBounds(LightBounds &bounds) const
+{
+    bounds = GetPointBounds(position, GetMaxIntensity());
+
+    ExtendBounds(bounds, position + edgeVectorU);
+    ExtendBounds(bounds, position + edgeVectorV);
+    ExtendBounds(bounds, position + edgeVectorU + edgeVectorV);
+
+    bounds.axis = lightNormal.GetNormalized();
+    bounds.cosThetaO = 1.f;
+    bounds.twoSided = true;
+
+    return true;
+}
\ No newline at end of file
@@ -23,7 +23,9 @@ public:
     }
 
     Vector3 GetPosition() const override;
+    Vector3 SamplePosition(float u, float v, Vector3 &lightNormal) const override;
     virtual Vector3 GetIntensityAtPosition(const Vector3& lightPosition, const Vector3& positionAt) const override;
+    bool GetBounds(LightBounds &bounds) const override;
 
     Vector3 edgeVectorU;
     Vector3 edgeVectorV;
@@ -4,4 +4,106 @@
  *	2018
  */
 
-#include "BRDF.h"
\ No newline at end of file
+#include "BRDF.h"
+
+#include "RandomGenerator.h"
+#include "Ray.h"
+
+bool BRDF::Sample(const Vector3 &diffuse, const Vector3 &specular, const Vector3 &n, const Vector3 &wo, Vector3 &wi, Vector3 &value, float &pdf) const
+{
+    float diffuseWeight = diffuse.GetMaxComponent();
+    float specularWeight = specular.GetMaxComponent();
+
+    if(diffuseWeight + specularWeight <= 0.f)
+    {
+        return false;
+    }
+
+    if(RandomGenerator::GetRandomFloat() * (diffuseWeight + specularWeight) < diffuseWeight)
+    {
+        wi = Ray::GetCosineWeightedHemiSphericalDirection(n);
+    }
+    else
+    {
+        wi = SampleSpecular(n, wo);
+    }
+
+    // Both lobes can produce wi, so its density is the mixture of theirs
+    pdf = Pdf(diffuse, specular, n, wo, wi);
+
+    if(pdf <= 0.f)
+    {
+        return false;
+    }
+
+    value = GetBRDF(diffuse, specular, n, wo, wi);
+
+    return true;
+}
+
+float BRDF::Pdf(const Vector3 &diffuse, const Vector3 &specular, const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const
+{
+    float diffuseWeight = diffuse.GetMaxComponent();
+    float specularWeight = specular.GetMaxComponent();
+    float cosTetha = Vector3::Dot(n, wi);
+
+    if(diffuseWeight + specularWeight <= 0.f || cosTetha <= 0.f)
+    {
+        return 0.f;
+    }
+
+    float diffusePdf = cosTetha * ONE_OVER_PI;
+    float specularPdf = specularWeight > 0.f ? GetSpecularPdf(n, wo, wi) : 0.f;
+
+    return (diffuseWeight * diffusePdf + specularWeight * specularPdf) / (diffuseWeight + specularWeight);
+}
+
+Vector3 LobeSamplingOps::SampleReflectionLobe(float p, const Vector3 &n, const Vector3 &wo)
+{
+    Vector3 reflectionVector = 2 * n * Vector3::Dot(n, wo) - wo;
+
+    float cosAlpha = std::pow(RandomGenerator::GetRandomFloat(), 1.f / (p + 1));
+    float phi = TWO_PI * RandomGenerator::GetRandomFloat();
+
+    return Ray::GetDirectionAround(reflectionVector.GetNormalized(), cosAlpha, phi);
+}
+
+float LobeSamplingOps::GetReflectionLobePdf(float p, const Vector3 &n, const Vector3 &wo, const Vector3 &wi)
+{
+    Vector3 reflectionVector = 2 * n * Vector3::Dot(n, wo) - wo;
+    float cosAlpha = Vector3::Dot(reflectionVector.GetNormalized(), wi);
+
+    if(cosAlpha <= 0.f)
+    {
+        return 0.f;
+    }
+
+    return (p + 1) * std::pow(cosAlpha, p) / TWO_PI;
+}
+
+Vector3 LobeSamplingOps::SampleHalfVectorLobe(float p, const Vector3 &n, const Vector3 &wo)
+{
+    float cosAlpha = std::pow(RandomGenerator::GetRandomFloat(), 1.f / (p + 1));
+    float phi = TWO_PI * RandomGenerator::GetRandomFloat();
+
+    Vector3 wh = Ray::GetDirectionAround(n, cosAlpha, phi);
+
+    return 2 * wh * Vector3::Dot(wo, wh) - wo;
+}
+
+float LobeSamplingOps::GetHalfVectorLobePdf(float p, const Vector3 &n, const Vector3 &wo, const Vector3 &wi)
+{
+    Vector3 wh = wi + wo;
+    wh.Normalize();
+
+    float cosAlpha = Vector3::Dot(n, wh);
+    float cosBeta = Vector3::Dot(wo, wh);
+
+    if(cosAlpha <= 0.f || cosBeta <= 0.f)
+    {
+        return 0.f;
+    }
+
+    // Density of the half vector over the Jacobian of reflecting wo about it
+    return (p + 1) * std::pow(cosAlpha, p) / (TWO_PI * 4 * cosBeta);
+}
\ No newline at end of file
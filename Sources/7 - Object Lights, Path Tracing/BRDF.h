@@ -13,11 +13,67 @@
 struct BRDF
 {
     virtual Vector3 GetBRDF(const Vector3 &diffuse, const Vector3 &specular, const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const = 0;
+
+    // Picks wi from the cosine weighted diffuse lobe or the specular lobe, proportional to their reflectances
+    // value is GetBRDF of the directions and pdf the solid angle density of wi, returns false when wi is below the surface
+    bool Sample(const Vector3 &diffuse, const Vector3 &specular, const Vector3 &n, const Vector3 &wo, Vector3 &wi, Vector3 &value, float &pdf) const;
+
+    // Density of Sample picking wi
+    float Pdf(const Vector3 &diffuse, const Vector3 &specular, const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const;
     
     float exponent;
+
+protected:
+    // Picks wi roughly proportional to the specular term of the BRDF
+    virtual Vector3 SampleSpecular(const Vector3 &n, const Vector3 &wo) const = 0;
+
+    // Density of SampleSpecular picking wi
+    virtual float GetSpecularPdf(const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const = 0;
+};
+
+// Specular lobes the BRDFs sample their directions from
+struct LobeSamplingOps
+{
+    // wi with the density (p + 1) / 2PI * cos^p of its angle to the mirror direction of wo
+    static Vector3 SampleReflectionLobe(float p, const Vector3 &n, const Vector3 &wo);
+    static float GetReflectionLobePdf(float p, const Vector3 &n, const Vector3 &wo, const Vector3 &wi);
+
+    // wi reflecting wo about a half vector with the density (p + 1) / 2PI * cos^p of its angle to the normal
+    static Vector3 SampleHalfVectorLobe(float p, const Vector3 &n, const Vector3 &wo);
+    static float GetHalfVectorLobePdf(float p, const Vector3 &n, const Vector3 &wo, const Vector3 &wi);
+};
+
+// Phong BRDFs sample around the mirror direction of wo
+struct PhongBRDF : public BRDF
+{
+protected:
+    Vector3 SampleSpecular(const Vector3 &n, const Vector3 &wo) const override
+    {
+        return LobeSamplingOps::SampleReflectionLobe(exponent, n, wo);
+    }
+
+    float GetSpecularPdf(const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const override
+    {
+        return LobeSamplingOps::GetReflectionLobePdf(exponent, n, wo, wi);
+    }
 };
 
-struct OriginalPhong : public BRDF
+// Blinn-Phong BRDFs sample their half vector around the normal
+struct BlinnPhongBRDF : public BRDF
+{
+protected:
+    Vector3 SampleSpecular(const Vector3 &n, const Vector3 &wo) const override
+    {
+        return LobeSamplingOps::SampleHalfVectorLobe(exponent, n, wo);
+    }
+
+    float GetSpecularPdf(const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const override
+    {
+        return LobeSamplingOps::GetHalfVectorLobePdf(exponent, n, wo, wi);
+    }
+};
+
+struct OriginalPhong : public PhongBRDF
 {
     Vector3 GetBRDF(const Vector3 &diffuse, const Vector3 &specular, const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const override
     {
@@ -26,8 +82,8 @@ struct OriginalPhong : public BRDF
 
         if(tethaI < HALF_PI)
         {
-            Vector3 reflectionVector = wi - 2 * n * Vector3::Dot(n, wi);
-            float cosAlphaR = Vector3::Dot(reflectionVector.GetNormalized(), wo);
+            Vector3 reflectionVector = 2 * n * Vector3::Dot(n, wi) - wi;
+            float cosAlphaR = mathMax(0, Vector3::Dot(reflectionVector.GetNormalized(), wo));
             return diffuse * cosTethaI + specular * std::pow(cosAlphaR, exponent);
         }
 
@@ -35,7 +91,7 @@ struct OriginalPhong : public BRDF
     }
 };
 
-struct ModifiedPhong : public BRDF
+struct ModifiedPhong : public PhongBRDF
 {
     Vector3 GetBRDF(const Vector3 &diffuse, const Vector3 &specular, const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const override
     {
@@ -45,8 +101,8 @@ struct ModifiedPhong : public BRDF
         //if(DEGREE_TO_RADIAN(tethaI) < 90.f)
         if(tethaI < HALF_PI)
         {
-            Vector3 reflectionVector = wi - 2 * n * Vector3::Dot(wi, n);
-            float cosAlphaR = Vector3::Dot(reflectionVector, wo);
+            Vector3 reflectionVector = 2 * n * Vector3::Dot(wi, n) - wi;
+            float cosAlphaR = mathMax(0, Vector3::Dot(reflectionVector, wo));
             return (diffuse + specular * std::pow(cosAlphaR, exponent)) * cosTethaI;
         }
 
@@ -54,7 +110,7 @@ struct ModifiedPhong : public BRDF
     }
 };
 
-struct NormalizedModifiedPhong : public BRDF
+struct NormalizedModifiedPhong : public PhongBRDF
 {
     Vector3 GetBRDF(const Vector3 &diffuse, const Vector3 &specular, const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const override
     {
@@ -64,8 +120,8 @@ struct NormalizedModifiedPhong : public BRDF
         //if(DEGREE_TO_RADIAN(tethaI) < 90.f)
         if(tethaI < HALF_PI)
         {
-            Vector3 reflectionVector = wi - 2 * n * Vector3::Dot(wi, n);
-            float cosAlphaR = Vector3::Dot(reflectionVector, wo);
+            Vector3 reflectionVector = 2 * n * Vector3::Dot(wi, n) - wi;
+            float cosAlphaR = mathMax(0, Vector3::Dot(reflectionVector, wo));
             return (diffuse * ONE_OVER_PI + (specular * (exponent + 2) / TWO_PI) * std::pow(cosAlphaR, exponent)) * cosTethaI;
         }
 
@@ -73,7 +129,7 @@ struct NormalizedModifiedPhong : public BRDF
     }
 };
 
-struct OriginalBlinnPhong : public BRDF
+struct OriginalBlinnPhong : public BlinnPhongBRDF
 {
     Vector3 GetBRDF(const Vector3 &diffuse, const Vector3 &specular, const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const override
     {
@@ -95,7 +151,7 @@ struct OriginalBlinnPhong : public BRDF
     }
 };
 
-struct ModifiedBlinnPhong : public BRDF
+struct ModifiedBlinnPhong : public BlinnPhongBRDF
 {
     Vector3 GetBRDF(const Vector3 &diffuse, const Vector3 &specular, const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const override
     {
@@ -117,7 +173,7 @@ struct ModifiedBlinnPhong : public BRDF
     }
 };
 
-struct NormalizedModifiedBlinnPhong : public BRDF
+struct NormalizedModifiedBlinnPhong : public BlinnPhongBRDF
 {
     Vector3 GetBRDF(const Vector3 &diffuse, const Vector3 &specular, const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const override
     {
@@ -195,6 +251,18 @@ struct TorranceSparrow : public BRDF
 
         return Vector3::ZeroVector;
     }
+
+protected:
+    // Samples the half vector proportional to D * cos(alpha), which integrates to 1 over the hemisphere
+    Vector3 SampleSpecular(const Vector3 &n, const Vector3 &wo) const override
+    {
+        return LobeSamplingOps::SampleHalfVectorLobe(exponent + 1, n, wo);
+    }
+
+    float GetSpecularPdf(const Vector3 &n, const Vector3 &wo, const Vector3 &wi) const override
+    {
+        return LobeSamplingOps::GetHalfVectorLobePdf(exponent + 1, n, wo, wi);
+    }
 };
 
 #endif
\ No newline at end of file
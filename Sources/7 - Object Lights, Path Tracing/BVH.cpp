@@ -37,6 +37,16 @@ bool BVH::Intersection(const Ray &ray, float& t, Vector3& n, float &beta, float
     return root->Intersection(ray, t, n, beta, gamma, hitObject, shadowCheck);
 }
 
+bool BVH::OcclusionIntersection(const Ray &ray) const
+{
+    return root->OcclusionIntersection(ray);
+}
+
+Mask8 BVH::OcclusionIntersection(const RayPacket8 &packet, const Mask8 &active) const
+{
+    return root->OcclusionIntersection(packet, active);
+}
+
 void BVH::CreateBVH(Mesh *mesh)
 {
     mesh->bvh.root = RecursivelySplit(mesh->faces, AXIS::X);
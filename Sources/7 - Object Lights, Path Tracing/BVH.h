@@ -41,6 +41,10 @@ public:
 
     bool Intersection(const Ray &ray, float& t, Vector3& n, float &beta, float &gamma, const ObjectBase **hitObject, bool shadowCheck) const;
 
+    bool OcclusionIntersection(const Ray &ray) const;
+
+    Mask8 OcclusionIntersection(const RayPacket8 &packet, const Mask8 &active) const;
+
     void DestructorHelper(ObjectBase *obj);
 
     void CreateBVH(Mesh *mesh);
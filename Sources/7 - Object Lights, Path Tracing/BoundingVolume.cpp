@@ -6,100 +6,142 @@
 
 #include "BoundingVolume.h"
 
-bool BoundingVolume::Intersection(const Ray &ray, float& t, Vector3& n, float &beta, float &gamma, const ObjectBase **hitObject, bool shadowCheck) const
+bool BoundingVolume::SlabTest(const Ray &ray) const
 {
     // Liang-Barsky Algorithm
 
-    Vector3 invD = Vector3(1 / ray.dir.x, 1 / ray.dir.y, 1 / ray.dir.z);
-    
-    float tmin, tmax, tymin, tymax, tzmin, tzmax;
-
-    bool xLessThanZero, yLessThanZero, zLessThanZero;
-
-    xLessThanZero = invD.x < 0;
-    yLessThanZero = invD.y < 0;
-    zLessThanZero = invD.z < 0;
-
-    Vector3 bounds[2] = {min, max};
-
-    tmin = (bounds[xLessThanZero].x - ray.e.x) * invD.x; 
-    tmax = (bounds[1-xLessThanZero].x - ray.e.x) * invD.x; 
-    tymin = (bounds[yLessThanZero].y - ray.e.y) * invD.y; 
-    tymax = (bounds[1 - yLessThanZero].y - ray.e.y) * invD.y; 
- 
-    if ((tmin > tymax) || (tymin > tmax)) 
-        return false; 
-    if (tymin > tmin) 
-        tmin = tymin; 
-    if (tymax < tmax) 
-        tmax = tymax; 
- 
-    tzmin = (bounds[zLessThanZero].z - ray.e.z) * invD.z; 
-    tzmax = (bounds[1-zLessThanZero].z - ray.e.z) * invD.z; 
- 
-    if ((tmin > tzmax) || (tzmin > tmax)) 
-        return false; 
-    if (tzmin > tmin) 
-        tmin = tzmin; 
-    if (tzmax < tmax) 
-        tmax = tzmax; 
- 
-    float tLeft, tRight;
-    float hitBetaLeft, hitGammaLeft;
+    const Vector3 bounds[2] = {min, max};
+
+    float tmin = (bounds[ray.sign[0]].x - ray.e.x) * ray.invDir.x;
+    float tmax = (bounds[1 - ray.sign[0]].x - ray.e.x) * ray.invDir.x;
+    float tymin = (bounds[ray.sign[1]].y - ray.e.y) * ray.invDir.y;
+    float tymax = (bounds[1 - ray.sign[1]].y - ray.e.y) * ray.invDir.y;
+
+    if ((tmin > tymax) || (tymin > tmax))
+        return false;
+    if (tymin > tmin)
+        tmin = tymin;
+    if (tymax < tmax)
+        tmax = tymax;
+
+    float tzmin = (bounds[ray.sign[2]].z - ray.e.z) * ray.invDir.z;
+    float tzmax = (bounds[1 - ray.sign[2]].z - ray.e.z) * ray.invDir.z;
+
+    if ((tmin > tzmax) || (tzmin > tmax))
+        return false;
+    if (tzmin > tmin)
+        tmin = tzmin;
+    if (tzmax < tmax)
+        tmax = tzmax;
+
+    // The box is outside of the ray's valid interval
+    return tmax > ray.tMin && tmin < ray.tMax;
+}
+
+Mask8 BoundingVolume::SlabTest(const RayPacket8 &packet) const
+{
+    // Near and far bounds of the lanes are selected with the signs of their inverse directions
+    Mask8 negativeX = packet.invDir.x < Float8(0.f);
+    Mask8 negativeY = packet.invDir.y < Float8(0.f);
+    Mask8 negativeZ = packet.invDir.z < Float8(0.f);
+
+    Float8 tmin = (Float8::Select(negativeX, Float8(max.x), Float8(min.x)) - packet.e.x) * packet.invDir.x;
+    Float8 tmax = (Float8::Select(negativeX, Float8(min.x), Float8(max.x)) - packet.e.x) * packet.invDir.x;
+    Float8 tymin = (Float8::Select(negativeY, Float8(max.y), Float8(min.y)) - packet.e.y) * packet.invDir.y;
+    Float8 tymax = (Float8::Select(negativeY, Float8(min.y), Float8(max.y)) - packet.e.y) * packet.invDir.y;
+
+    Mask8 missed = (tmin > tymax) | (tymin > tmax);
+    tmin = Float8::Select(tymin > tmin, tymin, tmin);
+    tmax = Float8::Select(tymax < tmax, tymax, tmax);
+
+    Float8 tzmin = (Float8::Select(negativeZ, Float8(max.z), Float8(min.z)) - packet.e.z) * packet.invDir.z;
+    Float8 tzmax = (Float8::Select(negativeZ, Float8(min.z), Float8(max.z)) - packet.e.z) * packet.invDir.z;
+
+    missed = missed | (tmin > tzmax) | (tzmin > tmax);
+    tmin = Float8::Select(tzmin > tmin, tzmin, tmin);
+    tmax = Float8::Select(tzmax < tmax, tzmax, tmax);
+
+    return !missed & (tmax > packet.tMin) & (tmin < packet.tMax);
+}
+
+bool BoundingVolume::Intersection(const Ray &ray, float& t, Vector3& n, float &beta, float &gamma, const ObjectBase **hitObject, bool shadowCheck) const
+{
+    if(!SlabTest(ray))
+    {
+        return false;
+    }
+
+    float tRight;
     float hitBetaRight, hitGammaRight;
-    const ObjectBase * leftObject;
     const ObjectBase * rightObject;
+    Vector3 nRight;
 
-    Vector3 nLeft, nRight;
-    bool leftIntersection = false, rightIntersection = false;
+    bool intersection = false;
 
-    if(left) 
+    if(left && left->Intersection(ray, t, n, beta, gamma, hitObject, shadowCheck))
     {
-        leftIntersection = left->Intersection(ray, tLeft, nLeft, hitBetaLeft, hitGammaLeft, &leftObject, shadowCheck);
+        intersection = true;
     }
 
-    if(right)
+    if(!right)
     {
-        rightIntersection = right->Intersection(ray, tRight, nRight, hitBetaRight, hitGammaRight, &rightObject, shadowCheck);
+        return intersection;
     }
-    
-    if(leftIntersection && rightIntersection)
+
+    bool rightIntersection;
+
+    if(intersection)
     {
-        if(tLeft < tRight)
-        {
-            t = tLeft;
-            n = nLeft;
-            beta = hitBetaLeft;
-            gamma = hitGammaLeft;
-            *hitObject = leftObject;
-        }
-        else
-        {
-            t = tRight;
-            n = nRight;
-            beta = hitBetaRight;
-            gamma = hitGammaRight;
-            *hitObject = leftObject;
-        }
+        // The right child only has to find hits closer than the left one
+        Ray closerRay = ray;
+        closerRay.tMax = t;
+        rightIntersection = right->Intersection(closerRay, tRight, nRight, hitBetaRight, hitGammaRight, &rightObject, shadowCheck);
     }
-    else if(leftIntersection)
+    else
     {
-        t = tLeft;
-        n = nLeft;
-        beta = hitBetaLeft;
-        gamma = hitGammaLeft;
-        *hitObject = leftObject;
+        rightIntersection = right->Intersection(ray, tRight, nRight, hitBetaRight, hitGammaRight, &rightObject, shadowCheck);
     }
-    else if(rightIntersection)
+
+    if(rightIntersection && (!intersection || tRight < t))
     {
         t = tRight;
         n = nRight;
         beta = hitBetaRight;
         gamma = hitGammaRight;
         *hitObject = rightObject;
+
+        intersection = true;
     }
-    
-    return leftIntersection || rightIntersection;
+
+    return intersection;
+}
+
+bool BoundingVolume::OcclusionIntersection(const Ray &ray) const
+{
+    // Any hit is enough, so the right child is not visited once the left one is occluding
+    return SlabTest(ray) && ((left && left->OcclusionIntersection(ray)) || (right && right->OcclusionIntersection(ray)));
+}
+
+Mask8 BoundingVolume::OcclusionIntersection(const RayPacket8 &packet, const Mask8 &active) const
+{
+    Mask8 entering = active & SlabTest(packet);
+
+    if(entering.None())
+    {
+        return entering;
+    }
+
+    Mask8 occluded = left ? left->OcclusionIntersection(packet, entering) : Mask8::FromBits(0);
+
+    // Only the lanes the left child does not occlude visit the right one
+    Mask8 remaining = entering & !occluded;
+
+    if(right && remaining.Any())
+    {
+        occluded = occluded | right->OcclusionIntersection(packet, remaining);
+    }
+
+    return occluded;
 }
 
 Vector3 BoundingVolume::GetCentroid()
@@ -52,6 +52,17 @@ public:
     Vector3 GetCentroid() override;
 
     bool Intersection(const Ray &ray, float &t, Vector3& n, float &beta, float &gamma, const ObjectBase ** hitObject, bool shadowCheck = false) const override;
+
+    bool OcclusionIntersection(const Ray &ray) const override;
+
+    // Lanes that enter the box visit the children together, the leaves test them one by one
+    Mask8 OcclusionIntersection(const RayPacket8 &packet, const Mask8 &active) const override;
+
+    // Returns true when the ray enters the box within its valid interval
+    bool SlabTest(const Ray &ray) const;
+
+    // Packet version, every lane is computed as the ray version computes it
+    Mask8 SlabTest(const RayPacket8 &packet) const;
     
     Vector3 min;
     Vector3 max;
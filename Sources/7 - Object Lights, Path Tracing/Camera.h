@@ -9,8 +9,12 @@
 
 #include <string>
 
+#include "Filter.h"
 #include "Math.h"
 
+#define ADAPTIVE_DEFAULT_MIN_SAMPLES 16
+#define ADAPTIVE_DEFAULT_NOISE_THRESHOLD 0.02f
+
 enum class TONE_MAPPING_TYPE : uint8_t
 {
     FILMIC = 0,
@@ -61,6 +65,25 @@ public:
     unsigned int imageWidth;
     unsigned int imageHeight;
     unsigned int numberOfSamples;
+
+    // Adaptive sampling takes minSamples per pixel first and keeps sampling the pixels whose
+    // relative standard error is above noiseThreshold, numberOfSamples is the maximum then
+    bool adaptiveSampling = false;
+    unsigned int minSamples = ADAPTIVE_DEFAULT_MIN_SAMPLES;
+    float noiseThreshold = ADAPTIVE_DEFAULT_NOISE_THRESHOLD;
+
+    // Reconstruction filter of the tile renderer, without one a centre sample and Gaussian weighted samples are taken
+    bool useFilter = false;
+    FILTER_TYPE filterType = FILTER_TYPE::GAUSSIAN;
+    FILTER_MODE filterMode = FILTER_MODE::WEIGHTED;
+    float filterRadius = DEFAULT_FILTER_RADIUS;
+
+    // Progressive rendering refines the whole image in passes that double its sample count
+    // It stops at numberOfSamples or once timeBudget seconds are spent, 0 means no budget
+    // Intermediate images are written every outputInterval seconds, 0 writes none
+    bool progressive = false;
+    float timeBudget = 0.f;
+    float outputInterval = 0.f;
     
     TONE_MAPPING_TYPE TMO = TONE_MAPPING_TYPE::NONE;
     GAMMA_CORRECTION gammaCorrection = GAMMA_CORRECTION::NONE;
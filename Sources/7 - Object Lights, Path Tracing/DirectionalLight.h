@@ -29,7 +29,7 @@ public:
         return direction;
     }
 
-    bool ShadowCheck(const Vector3& lightPosition, const Vector3& positionAt) const override;
+    Ray GetShadowRay(const Vector3& lightPosition, const Vector3& positionAt) const override;
 
     Vector3 direction;
     Vector3 radiance;
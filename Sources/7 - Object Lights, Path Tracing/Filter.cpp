@@ -0,0 +1,102 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#include "Filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Math.h"
+
+// Mitchell-Netravali with B = C = 1 / 3 over [0, 2]
+static float MitchellWeight(float x)
+{
+    const float B = 1.f / 3.f;
+    const float C = 1.f / 3.f;
+
+    if(x < 1.f)
+    {
+        return ((12.f - 9.f * B - 6.f * C) * x * x * x + (-18.f + 12.f * B + 6.f * C) * x * x + (6.f - 2.f * B)) / 6.f;
+    }
+
+    if(x < 2.f)
+    {
+        return ((-B - 6.f * C) * x * x * x + (6.f * B + 30.f * C) * x * x + (-12.f * B - 48.f * C) * x + (8.f * B + 24.f * C)) / 6.f;
+    }
+
+    return 0.f;
+}
+
+Filter::Filter(FILTER_TYPE type, float radius, FILTER_MODE mode) :
+    radius(radius > 0.f ? radius : DEFAULT_FILTER_RADIUS),
+    mode(mode)
+{
+    tableScale = FILTER_TABLE_SIZE / this->radius;
+
+    // Gaussian falloff, shifted so it reaches zero at the radius
+    const float gaussianAlpha = 2.f;
+    float gaussianEdge = exp(-gaussianAlpha * this->radius * this->radius);
+
+    for(int tableIndex = 0; tableIndex < FILTER_TABLE_SIZE; tableIndex++)
+    {
+        float offset = (tableIndex + 0.5f) / tableScale;
+
+        switch(type)
+        {
+            case FILTER_TYPE::BOX:
+                weights[tableIndex] = 1.f;
+                break;
+            case FILTER_TYPE::TENT:
+                weights[tableIndex] = this->radius - offset;
+                break;
+            case FILTER_TYPE::GAUSSIAN:
+                weights[tableIndex] = mathMax(0.f, exp(-gaussianAlpha * offset * offset) - gaussianEdge);
+                break;
+            case FILTER_TYPE::MITCHELL:
+                weights[tableIndex] = MitchellWeight(2.f * offset / this->radius);
+                break;
+        }
+    }
+
+    // Cells run from -radius to radius, the table is mirrored for the negative half
+    cdf[0] = 0.f;
+
+    for(int cellIndex = 0; cellIndex < 2 * FILTER_TABLE_SIZE; cellIndex++)
+    {
+        int tableIndex = cellIndex < FILTER_TABLE_SIZE ? FILTER_TABLE_SIZE - 1 - cellIndex : cellIndex - FILTER_TABLE_SIZE;
+        cdf[cellIndex + 1] = cdf[cellIndex] + std::fabs(weights[tableIndex]);
+    }
+
+    for(int cellIndex = 1; cellIndex <= 2 * FILTER_TABLE_SIZE; cellIndex++)
+    {
+        cdf[cellIndex] /= cdf[2 * FILTER_TABLE_SIZE];
+    }
+}
+
+void Filter::SampleOffset(float u, float v, float &dx, float &dy, float &weight) const
+{
+    float signX, signY;
+
+    dx = SampleOffset(u, signX);
+    dy = SampleOffset(v, signY);
+
+    weight = signX * signY;
+}
+
+float Filter::SampleOffset(float u, float &sign) const
+{
+    int cellIndex = (int)(std::upper_bound(cdf, cdf + 2 * FILTER_TABLE_SIZE + 1, u) - cdf) - 1;
+    cellIndex = mathClamp(cellIndex, 0, 2 * FILTER_TABLE_SIZE - 1);
+
+    int tableIndex = cellIndex < FILTER_TABLE_SIZE ? FILTER_TABLE_SIZE - 1 - cellIndex : cellIndex - FILTER_TABLE_SIZE;
+    sign = weights[tableIndex] < 0.f ? -1.f : 1.f;
+
+    // Uniform inside the cell
+    float cellWidth = cdf[cellIndex + 1] - cdf[cellIndex];
+    float cellPosition = cellWidth > 0.f ? (u - cdf[cellIndex]) / cellWidth : 0.5f;
+
+    return (cellIndex + cellPosition) / tableScale - radius;
+}
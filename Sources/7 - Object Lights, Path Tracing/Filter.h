@@ -0,0 +1,83 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#ifndef __FILTER_H__
+#define __FILTER_H__
+
+#include <cstdint>
+
+#define DEFAULT_FILTER_RADIUS 1.5f
+
+// Entries of the weight table over [0, radius]
+#define FILTER_TABLE_SIZE 64
+
+enum class FILTER_TYPE : uint8_t
+{
+    BOX = 0,
+    TENT,
+    GAUSSIAN,
+    MITCHELL
+};
+
+enum class FILTER_MODE : uint8_t
+{
+    // Samples stay in their pixel and are weighted by the filter
+    WEIGHTED = 0,
+    // Samples are added to every pixel within the radius
+    SPLAT,
+    // Samples are distributed like the filter, so they only carry its sign as weight
+    IMPORTANCE
+};
+
+/*
+    Separable pixel reconstruction filter
+    Weights and the sampling distribution are tabulated once, so no filter function is evaluated per sample
+*/
+class Filter
+{
+public:
+    Filter(FILTER_TYPE type, float radius, FILTER_MODE mode);
+
+    // Weight of a sample at offset (dx, dy) from the pixel center
+    inline float Evaluate(float dx, float dy) const
+    {
+        return Evaluate(dx) * Evaluate(dy);
+    }
+
+    // Maps uniform numbers to an offset distributed like the absolute filter, weight gets the filter's sign there
+    void SampleOffset(float u, float v, float &dx, float &dy, float &weight) const;
+
+    inline float GetRadius() const
+    {
+        return radius;
+    }
+
+    inline FILTER_MODE GetMode() const
+    {
+        return mode;
+    }
+
+private:
+    inline float Evaluate(float offset) const
+    {
+        float tablePosition = (offset < 0.f ? -offset : offset) * tableScale;
+        return tablePosition < FILTER_TABLE_SIZE ? weights[(int)tablePosition] : 0.f;
+    }
+
+    // Samples the 1D distribution over [-radius, radius], returns the offset and its weight's sign
+    float SampleOffset(float u, float &sign) const;
+
+    float radius;
+    float tableScale;
+    FILTER_MODE mode;
+
+    float weights[FILTER_TABLE_SIZE];
+
+    // Cumulative distribution of the absolute weights over the 2 * FILTER_TABLE_SIZE cells of [-radius, radius]
+    float cdf[2 * FILTER_TABLE_SIZE + 1];
+};
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#include "ImageWriter.h"
+
+#include <iostream>
+#include <string>
+
+#include "Camera.h"
+#include "IOManager.h"
+
+std::thread ImageWriter::writerThread;
+std::deque<ImageWriter::Job> ImageWriter::jobs;
+
+std::mutex ImageWriter::mutex;
+std::condition_variable ImageWriter::jobCondition;
+bool ImageWriter::stopping = false;
+
+void ImageWriter::Start()
+{
+    stopping = false;
+    writerThread = std::thread(&ImageWriter::WriterFunction);
+}
+
+void ImageWriter::Enqueue(const Camera *camera, int imageWidth, int imageHeight, float *image, float *toneMappingImage, float *heatmapImage)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(Job{ camera, imageWidth, imageHeight, image, toneMappingImage, heatmapImage });
+    }
+
+    jobCondition.notify_one();
+}
+
+void ImageWriter::Finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    jobCondition.notify_one();
+
+    if(writerThread.joinable())
+    {
+        writerThread.join();
+    }
+}
+
+void ImageWriter::WriterFunction()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while(true)
+    {
+        jobCondition.wait(lock, []{ return stopping || !jobs.empty(); });
+
+        // Queued images are still written when stopping
+        if(jobs.empty())
+        {
+            return;
+        }
+
+        Job job = jobs.front();
+        jobs.pop_front();
+
+        lock.unlock();
+
+        WriteImages(job);
+
+        delete[] job.image;
+        delete[] job.toneMappingImage;
+        delete[] job.heatmapImage;
+
+        lock.lock();
+    }
+}
+
+void ImageWriter::WriteImages(const Job &job)
+{
+    const Camera *camera = job.camera;
+
+    if(job.toneMappingImage)
+    {
+        std::string pngImageName = camera->imageName.substr(0, camera->imageName.length() - 4);
+        pngImageName += ".png";
+
+        IOManager::WritePng(pngImageName.c_str(), job.imageWidth, job.imageHeight, job.toneMappingImage);
+    }
+
+    if(job.heatmapImage)
+    {
+        std::string heatmapImageName = camera->imageName.substr(0, camera->imageName.length() - 4);
+        heatmapImageName += "_samples.png";
+
+        IOManager::WritePng(heatmapImageName.c_str(), job.imageWidth, job.imageHeight, job.heatmapImage);
+    }
+
+    std::string extension;
+    unsigned int imageNameLength = camera->imageName.length();
+
+    for(int nameIndex = imageNameLength - 1; nameIndex >= 0; nameIndex--)
+    {
+        if(camera->imageName.c_str()[nameIndex] != '.')
+        {
+            extension.insert(0, 1, camera->imageName.c_str()[nameIndex]);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if(extension == "png") IOManager::WritePng(camera->imageName.c_str(), job.imageWidth, job.imageHeight, job.image);
+    else if(extension == "exr") IOManager::WriteExr(camera->imageName.c_str(), job.imageWidth, job.imageHeight, job.image);
+    else if(extension == "ppm") true;//IOManager::WritePpm(camera->imageName.c_str(), job.imageWidth, job.imageHeight, job.image);
+    else std::cerr << "Output extension is unknown! Extension is: " << extension << std::endl;
+}
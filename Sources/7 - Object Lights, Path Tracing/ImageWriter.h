@@ -0,0 +1,57 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#ifndef __IMAGEWRITER_H__
+#define __IMAGEWRITER_H__
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+class Camera;
+
+/*
+    Static background image writer
+    Rendered images are queued and encoded on a thread of its own, so the pool keeps tracing meanwhile
+*/
+class ImageWriter
+{
+public:
+    // Starts the writer thread
+    static void Start();
+
+    // Queues the camera's image, its tone mapped image and its sample count heatmap, the last two may be nullptr
+    // The writer owns the buffers afterwards and deletes them once they are written
+    static void Enqueue(const Camera *camera, int imageWidth, int imageHeight, float *image, float *toneMappingImage, float *heatmapImage = nullptr);
+
+    // Writes the remaining images and stops the writer thread
+    static void Finish();
+
+private:
+    struct Job
+    {
+        const Camera *camera;
+        int imageWidth, imageHeight;
+        float *image;
+        float *toneMappingImage;
+        float *heatmapImage;
+    };
+
+    static void WriterFunction();
+
+    // Writes the camera's image, its tone mapped png and its heatmap png if there are
+    static void WriteImages(const Job &job);
+
+    static std::thread writerThread;
+    static std::deque<Job> jobs;
+
+    static std::mutex mutex;
+    static std::condition_variable jobCondition;
+    static bool stopping;
+};
+
+#endif
@@ -6,37 +6,32 @@
 
 #include "Light.h"
 
-#include "ObjectBase.h"
 #include "Scene.h"
 
-#include "LightMesh.h"
-#include "LightSphere.h"
-
-bool Light::ShadowCheck(const Vector3& lightPosition, const Vector3& positionAt) const
+Ray Light::GetShadowRay(const Vector3& lightPosition, const Vector3& positionAt) const
 {
     float distance = (lightPosition - positionAt).Length();
     Vector3 wi = -GetDirection(lightPosition, positionAt);
-    Vector3 o = positionAt + wi * SHADOW_EPSILON;
-
-    float closestT = 0;
-    float beta, gamma;
-    Vector3 closestN;
-    const ObjectBase *closestObject = nullptr;
 
-    Ray ray(o, wi);
-    mainScene->SingleRayTrace(ray, closestT, closestN, beta, gamma, &closestObject, true);
+    return Ray(positionAt, wi, SHADOW_EPSILON, distance);
+}
 
-    bool result = closestT > 0 && closestT < distance;
+bool Light::ShadowCheck(const Vector3& lightPosition, const Vector3& positionAt) const
+{
+    return mainScene->OcclusionTrace(GetShadowRay(lightPosition, positionAt));
+}
 
-    if(result && dynamic_cast<const LightMesh*>(closestObject->parentObject))
-    {
-        return false;
-    }
+LightBounds Light::GetPointBounds(const Vector3 &lightPosition, float power) const
+{
+    LightBounds bounds;
 
-    if(result && dynamic_cast<const LightSphere*>(closestObject))
-    {
-        return false;
-    }
+    bounds.min = lightPosition;
+    bounds.max = lightPosition;
+    bounds.axis = Vector3(0.f, 0.f, 1.f);
+    bounds.cosThetaO = -1.f;
+    bounds.cosThetaE = 0.f;
+    bounds.power = power;
+    bounds.twoSided = false;
 
-    return result;
+    return bounds;
 }
\ No newline at end of file
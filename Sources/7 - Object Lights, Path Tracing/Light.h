@@ -2,11 +2,29 @@
 #define __LIGHT_H__
 
 #include "Math.h"
+#include "Ray.h"
+
+// Where a light is and which directions it emits to, aggregated by the light BVH
+struct LightBounds
+{
+    Vector3 min, max;
+
+    // Emission is inside the cone of cosThetaO around the axis and fades out within cosThetaE past its border
+    Vector3 axis;
+    float cosThetaO;
+    float cosThetaE;
+
+    // Estimate of the emitted light, only compared between the lights
+    float power;
+
+    // Emits around the negated axis too
+    bool twoSided;
+};
 
 class Light
 {
 public:
-    Light()
+    Light() : sampleCount(1)
     {
         
     }
@@ -21,6 +39,27 @@ public:
         return position;
     }
 
+    // Point at (u, v) of the unit square mapped over the light, used for stratified sampling
+    // lightNormal is the surface normal there, zero for lights without a surface
+    virtual Vector3 SamplePosition(float /*u*/, float /*v*/, Vector3 &lightNormal) const
+    {
+        lightNormal = Vector3::ZeroVector;
+        return GetPosition();
+    }
+
+    // Solid angle density of SamplePosition picking lightPosition as seen from positionAt
+    // 0 for lights that rays cannot hit, their samples need no weighting against the surface's own sampling
+    virtual float GetPdf(const Vector3 &/*lightPosition*/, const Vector3 &/*lightNormal*/, const Vector3 &/*positionAt*/) const
+    {
+        return 0.f;
+    }
+
+    // True for the lights that are part of the scene's geometry, a sample of theirs with a density of 0 is on a side facing away from the point and lights nothing
+    virtual bool IsEmissiveGeometry() const
+    {
+        return false;
+    }
+
     virtual Vector3 GetDirection(const Vector3 &lightPosition, const Vector3 &referencePosition) const
     {
         return Vector3::GetNormalized(referencePosition - lightPosition);
@@ -28,10 +67,39 @@ public:
 
     virtual Vector3 GetIntensityAtPosition(const Vector3& lightPosition, const Vector3& positionAt) const = 0;
 
-    virtual bool ShadowCheck(const Vector3& lightPosition, const Vector3& positionAt) const;
+    // Returns false for lights without a position, they are not put into the light BVH
+    virtual bool GetBounds(LightBounds &/*bounds*/) const
+    {
+        return false;
+    }
+
+    // Ray from the position towards the light, its interval ends at the light
+    virtual Ray GetShadowRay(const Vector3& lightPosition, const Vector3& positionAt) const;
+
+    bool ShadowCheck(const Vector3& lightPosition, const Vector3& positionAt) const;
 
     Vector3 position;
     Vector3 intensity;
+
+    // Shadow samples per shading point, rounded down to a square grid of strata
+    unsigned int sampleCount;
+
+protected:
+    // Bounds of a light at the position emitting to every direction
+    LightBounds GetPointBounds(const Vector3 &lightPosition, float power) const;
+
+    // Grows the bounds to hold the point
+    static void ExtendBounds(LightBounds &bounds, const Vector3 &point)
+    {
+        bounds.min = Vector3(mathMin(bounds.min.x, point.x), mathMin(bounds.min.y, point.y), mathMin(bounds.min.z, point.z));
+        bounds.max = Vector3(mathMax(bounds.max.x, point.x), mathMax(bounds.max.y, point.y), mathMax(bounds.max.z, point.z));
+    }
+
+    // Brightest channel of the intensity
+    float GetMaxIntensity() const
+    {
+        return mathMax(intensity.x, mathMax(intensity.y, intensity.z));
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,461 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#include "LightBVH.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Largest float below one, keeps the reused random number inside [0, 1)
+static const float ONE_MINUS_EPSILON = std::nextafter(1.f, 0.f);
+
+// Splits past this depth halve the lights, so the bit trails fit in 64 bits
+#define LIGHT_BVH_MAX_COST_SPLIT_DEPTH 32
+
+static inline float GetComponent(const Vector3 &vector, unsigned int axis)
+{
+    return axis == 0 ? vector.x : axis == 1 ? vector.y : vector.z;
+}
+
+// cos(max(0, a - b)) from the sines and cosines of the angles
+static inline float CosSubClamped(float sinA, float cosA, float sinB, float cosB)
+{
+    if(cosA > cosB)
+    {
+        return 1.f;
+    }
+
+    return cosA * cosB + sinA * sinB;
+}
+
+// sin(max(0, a - b)) from the sines and cosines of the angles
+static inline float SinSubClamped(float sinA, float cosA, float sinB, float cosB)
+{
+    if(cosA > cosB)
+    {
+        return 0.f;
+    }
+
+    return sinA * cosB - cosA * sinB;
+}
+
+static inline float SinFromCos(float cosTheta)
+{
+    return sqrt(mathMax(0.f, 1.f - cosTheta * cosTheta));
+}
+
+static inline float SafeAcos(float value)
+{
+    return acos(mathClamp(value, -1.f, 1.f));
+}
+
+// Smallest cone holding both cones
+static void UnionCones(const Vector3 &axisA, float cosThetaA, const Vector3 &axisB, float cosThetaB, Vector3 &axis, float &cosTheta)
+{
+    float thetaA = SafeAcos(cosThetaA);
+    float thetaB = SafeAcos(cosThetaB);
+    float thetaD = SafeAcos(Vector3::Dot(axisA, axisB));
+
+    if(mathMin(thetaD + thetaB, PI) <= thetaA)
+    {
+        axis = axisA;
+        cosTheta = cosThetaA;
+        return;
+    }
+
+    if(mathMin(thetaD + thetaA, PI) <= thetaB)
+    {
+        axis = axisB;
+        cosTheta = cosThetaB;
+        return;
+    }
+
+    float thetaO = (thetaA + thetaD + thetaB) * 0.5f;
+    Vector3 rotationAxis = Vector3::Cross(axisA, axisB);
+    float rotationAxisLength = rotationAxis.Length();
+
+    if(thetaO >= PI || rotationAxisLength <= 0.f)
+    {
+        axis = axisA;
+        cosTheta = -1.f;
+        return;
+    }
+
+    // Rotates axisA towards axisB until the cone's border touches cone A's far border
+    rotationAxis /= rotationAxisLength;
+    float thetaR = thetaO - thetaA;
+    float cosThetaR = cos(thetaR);
+    float sinThetaR = sin(thetaR);
+
+    axis = axisA * cosThetaR + Vector3::Cross(rotationAxis, axisA) * sinThetaR + rotationAxis * (Vector3::Dot(rotationAxis, axisA) * (1.f - cosThetaR));
+    axis.Normalize();
+    cosTheta = cos(thetaO);
+}
+
+static LightBounds UnionBounds(const LightBounds &a, const LightBounds &b)
+{
+    if(a.power <= 0.f)
+    {
+        return b;
+    }
+
+    if(b.power <= 0.f)
+    {
+        return a;
+    }
+
+    LightBounds bounds;
+
+    bounds.min = Vector3(mathMin(a.min.x, b.min.x), mathMin(a.min.y, b.min.y), mathMin(a.min.z, b.min.z));
+    bounds.max = Vector3(mathMax(a.max.x, b.max.x), mathMax(a.max.y, b.max.y), mathMax(a.max.z, b.max.z));
+
+    UnionCones(a.axis, a.cosThetaO, b.axis, b.cosThetaO, bounds.axis, bounds.cosThetaO);
+    bounds.cosThetaE = mathMin(a.cosThetaE, b.cosThetaE);
+
+    bounds.power = a.power + b.power;
+    bounds.twoSided = a.twoSided || b.twoSided;
+
+    return bounds;
+}
+
+// Cosine of the half angle the bounds subtend seen from the point, -1 when the point is inside
+static float GetSubtendedCosine(const LightBounds &bounds, const Vector3 &point, const Vector3 &center)
+{
+    if(point.x >= bounds.min.x && point.y >= bounds.min.y && point.z >= bounds.min.z &&
+       point.x <= bounds.max.x && point.y <= bounds.max.y && point.z <= bounds.max.z)
+    {
+        return -1.f;
+    }
+
+    Vector3 halfDiagonal = bounds.max - center;
+    float squaredRadius = Vector3::Dot(halfDiagonal, halfDiagonal);
+
+    Vector3 toPoint = point - center;
+    float squaredDistance = Vector3::Dot(toPoint, toPoint);
+
+    if(squaredDistance < squaredRadius)
+    {
+        return -1.f;
+    }
+
+    return sqrt(mathMax(0.f, 1.f - squaredRadius / squaredDistance));
+}
+
+// Conservative estimate of the light the bounds send to the point, 0 only when none of it can reach
+static float GetImportance(const LightBounds &bounds, const Vector3 &point, const Vector3 &normal)
+{
+    Vector3 center = (bounds.min + bounds.max) * 0.5f;
+    Vector3 toPoint = point - center;
+    float distance = toPoint.Length();
+
+    // Points close to a large node would get an unbounded importance
+    float squaredDistance = mathMax(distance * distance, (bounds.max - bounds.min).Length() * 0.5f);
+
+    if(distance <= 0.f)
+    {
+        return squaredDistance > 0.f ? bounds.power / squaredDistance : bounds.power;
+    }
+
+    Vector3 direction = toPoint / distance;
+
+    float cosThetaW = Vector3::Dot(direction, bounds.axis);
+    if(bounds.twoSided) cosThetaW = std::fabs(cosThetaW);
+    float sinThetaW = SinFromCos(cosThetaW);
+
+    float cosThetaB = GetSubtendedCosine(bounds, point, center);
+    float sinThetaB = SinFromCos(cosThetaB);
+
+    // Smallest angle between the direction to the point and an emission direction of any point in the bounds
+    float sinThetaO = SinFromCos(bounds.cosThetaO);
+    float cosThetaX = CosSubClamped(sinThetaW, cosThetaW, sinThetaO, bounds.cosThetaO);
+    float sinThetaX = SinSubClamped(sinThetaW, cosThetaW, sinThetaO, bounds.cosThetaO);
+    float cosThetaP = CosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+
+    if(cosThetaP <= bounds.cosThetaE)
+    {
+        return 0.f;
+    }
+
+    float importance = bounds.power * cosThetaP / squaredDistance;
+
+    // Bounds entirely below the point's horizon do not light it
+    if(normal != Vector3::ZeroVector)
+    {
+        float cosThetaI = -Vector3::Dot(direction, normal);
+        float sinThetaI = SinFromCos(cosThetaI);
+
+        importance *= mathMax(0.f, CosSubClamped(sinThetaI, cosThetaI, sinThetaB, cosThetaB));
+    }
+
+    return mathMax(0.f, importance);
+}
+
+// Solid angle measure of the emission cones, the orientation term of the split cost
+static float GetOrientationMeasure(const LightBounds &bounds)
+{
+    float thetaO = SafeAcos(bounds.cosThetaO);
+    float thetaE = SafeAcos(bounds.cosThetaE);
+    float thetaW = mathMin(thetaO + thetaE, PI);
+    float sinThetaO = SinFromCos(bounds.cosThetaO);
+
+    return TWO_PI * (1.f - bounds.cosThetaO) +
+           HALF_PI * (2.f * thetaW * sinThetaO - cos(thetaO - 2.f * thetaW) - 2.f * thetaO * sinThetaO + bounds.cosThetaO);
+}
+
+static float GetSurfaceArea(const LightBounds &bounds)
+{
+    Vector3 extent = bounds.max - bounds.min;
+    return 2.f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+void LightBVH::Build(const std::vector<Light *> &lights)
+{
+    nodes.clear();
+    unboundedLights.clear();
+    bitTrails.clear();
+
+    std::vector<BoundedLight> boundedLights;
+
+    for(unsigned int lightIndex = 0; lightIndex < lights.size(); lightIndex++)
+    {
+        LightBounds bounds;
+
+        if(!lights[lightIndex]->GetBounds(bounds))
+        {
+            unboundedLights.push_back(lightIndex);
+        }
+        else if(bounds.power > 0.f)
+        {
+            boundedLights.push_back(BoundedLight(lightIndex, bounds));
+        }
+    }
+
+    if(!boundedLights.empty())
+    {
+        nodes.reserve(2 * boundedLights.size() - 1);
+        BuildNode(lights, boundedLights, 0, boundedLights.size(), 0, 0);
+    }
+}
+
+void LightBVH::BuildNode(const std::vector<Light *> &sceneLights, std::vector<BoundedLight> &lights, size_t begin, size_t end, uint64_t bitTrail, unsigned int depth)
+{
+    if(end - begin == 1)
+    {
+        nodes.push_back(Node{ lights[begin].second, lights[begin].first, true });
+        bitTrails[sceneLights[lights[begin].first]] = bitTrail;
+        return;
+    }
+
+    LightBounds bounds = lights[begin].second;
+    Vector3 centroidMin = (bounds.min + bounds.max) * 0.5f;
+    Vector3 centroidMax = centroidMin;
+
+    for(size_t lightIndex = begin + 1; lightIndex < end; lightIndex++)
+    {
+        const LightBounds &lightBounds = lights[lightIndex].second;
+        Vector3 centroid = (lightBounds.min + lightBounds.max) * 0.5f;
+
+        bounds = UnionBounds(bounds, lightBounds);
+        centroidMin = Vector3(mathMin(centroidMin.x, centroid.x), mathMin(centroidMin.y, centroid.y), mathMin(centroidMin.z, centroid.z));
+        centroidMax = Vector3(mathMax(centroidMax.x, centroid.x), mathMax(centroidMax.y, centroid.y), mathMax(centroidMax.z, centroid.z));
+    }
+
+    // Bucketed split along the axis with the lowest surface area orientation cost
+    float bestCost = MAX_FLOAT;
+    unsigned int bestAxis = 0;
+    unsigned int bestBucket = 0;
+
+    Vector3 extent = bounds.max - bounds.min;
+    float maxExtent = mathMax(extent.x, mathMax(extent.y, extent.z));
+
+    for(unsigned int axis = 0; axis < 3 && depth < LIGHT_BVH_MAX_COST_SPLIT_DEPTH; axis++)
+    {
+        float axisMin = GetComponent(centroidMin, axis);
+        float axisMax = GetComponent(centroidMax, axis);
+
+        if(axisMax <= axisMin)
+        {
+            continue;
+        }
+
+        LightBounds buckets[LIGHT_BVH_BUCKET_COUNT];
+
+        for(LightBounds &bucket : buckets)
+        {
+            bucket.power = 0.f;
+        }
+
+        for(size_t lightIndex = begin; lightIndex < end; lightIndex++)
+        {
+            const LightBounds &lightBounds = lights[lightIndex].second;
+            float centroid = GetComponent((lightBounds.min + lightBounds.max) * 0.5f, axis);
+
+            unsigned int bucketIndex = (unsigned int)(LIGHT_BVH_BUCKET_COUNT * (centroid - axisMin) / (axisMax - axisMin));
+            bucketIndex = mathMin(bucketIndex, LIGHT_BVH_BUCKET_COUNT - 1u);
+
+            buckets[bucketIndex] = UnionBounds(buckets[bucketIndex], lightBounds);
+        }
+
+        // Thin axes are penalized, splitting them hardly separates the lights
+        float axisExtent = GetComponent(extent, axis);
+        float thinness = axisExtent > 0.f ? maxExtent / axisExtent : 1.f;
+
+        for(unsigned int splitIndex = 0; splitIndex < LIGHT_BVH_BUCKET_COUNT - 1; splitIndex++)
+        {
+            LightBounds below, above;
+            below.power = 0.f;
+            above.power = 0.f;
+
+            for(unsigned int bucketIndex = 0; bucketIndex <= splitIndex; bucketIndex++)
+            {
+                below = UnionBounds(below, buckets[bucketIndex]);
+            }
+
+            for(unsigned int bucketIndex = splitIndex + 1; bucketIndex < LIGHT_BVH_BUCKET_COUNT; bucketIndex++)
+            {
+                above = UnionBounds(above, buckets[bucketIndex]);
+            }
+
+            if(below.power <= 0.f || above.power <= 0.f)
+            {
+                continue;
+            }
+
+            float cost = thinness * (below.power * GetOrientationMeasure(below) * GetSurfaceArea(below) +
+                                     above.power * GetOrientationMeasure(above) * GetSurfaceArea(above));
+
+            if(cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBucket = splitIndex;
+            }
+        }
+    }
+
+    size_t middle;
+
+    if(bestCost < MAX_FLOAT)
+    {
+        float axisMin = GetComponent(centroidMin, bestAxis);
+        float axisMax = GetComponent(centroidMax, bestAxis);
+
+        middle = std::partition(lights.begin() + begin, lights.begin() + end, [&](const BoundedLight &light)
+        {
+            float centroid = GetComponent((light.second.min + light.second.max) * 0.5f, bestAxis);
+
+            unsigned int bucketIndex = (unsigned int)(LIGHT_BVH_BUCKET_COUNT * (centroid - axisMin) / (axisMax - axisMin));
+            return mathMin(bucketIndex, LIGHT_BVH_BUCKET_COUNT - 1u) <= bestBucket;
+        }) - lights.begin();
+    }
+    else
+    {
+        // Lights at the same place or a deep tree, halved by count
+        middle = (begin + end) / 2;
+    }
+
+    size_t nodeIndex = nodes.size();
+    nodes.push_back(Node{ bounds, 0, false });
+
+    BuildNode(sceneLights, lights, begin, middle, bitTrail, depth + 1);
+
+    nodes[nodeIndex].index = nodes.size();
+    BuildNode(sceneLights, lights, middle, end, bitTrail | (1ull << depth), depth + 1);
+}
+
+bool LightBVH::Sample(const Vector3 &point, const Vector3 &normal, float u, unsigned int &lightIndex, float &probability) const
+{
+    if(nodes.empty())
+    {
+        return false;
+    }
+
+    probability = 1.f;
+    size_t nodeIndex = 0;
+
+    while(!nodes[nodeIndex].isLeaf)
+    {
+        float firstImportance = GetImportance(nodes[nodeIndex + 1].bounds, point, normal);
+        float secondImportance = GetImportance(nodes[nodes[nodeIndex].index].bounds, point, normal);
+
+        if(firstImportance <= 0.f && secondImportance <= 0.f)
+        {
+            return false;
+        }
+
+        float firstProbability = firstImportance / (firstImportance + secondImportance);
+
+        // The random number is rescaled into the picked child's share and reused
+        if(u < firstProbability)
+        {
+            u = mathMin(u / firstProbability, ONE_MINUS_EPSILON);
+            probability *= firstProbability;
+            nodeIndex = nodeIndex + 1;
+        }
+        else
+        {
+            u = mathMin((u - firstProbability) / (1.f - firstProbability), ONE_MINUS_EPSILON);
+            probability *= 1.f - firstProbability;
+            nodeIndex = nodes[nodeIndex].index;
+        }
+    }
+
+    // A lone light is not weighed against another one, it still has to reach the point
+    if(nodeIndex == 0 && GetImportance(nodes[0].bounds, point, normal) <= 0.f)
+    {
+        return false;
+    }
+
+    lightIndex = nodes[nodeIndex].index;
+    return true;
+}
+
+float LightBVH::GetProbability(const Vector3 &point, const Vector3 &normal, const Light *light) const
+{
+    auto bitTrailIterator = bitTrails.find(light);
+
+    if(bitTrailIterator == bitTrails.end())
+    {
+        return 0.f;
+    }
+
+    uint64_t bitTrail = bitTrailIterator->second;
+    float probability = 1.f;
+    size_t nodeIndex = 0;
+
+    while(!nodes[nodeIndex].isLeaf)
+    {
+        float firstImportance = GetImportance(nodes[nodeIndex + 1].bounds, point, normal);
+        float secondImportance = GetImportance(nodes[nodes[nodeIndex].index].bounds, point, normal);
+
+        if(firstImportance <= 0.f && secondImportance <= 0.f)
+        {
+            return 0.f;
+        }
+
+        float firstProbability = firstImportance / (firstImportance + secondImportance);
+
+        if(bitTrail & 1)
+        {
+            probability *= 1.f - firstProbability;
+            nodeIndex = nodes[nodeIndex].index;
+        }
+        else
+        {
+            probability *= firstProbability;
+            nodeIndex = nodeIndex + 1;
+        }
+
+        bitTrail >>= 1;
+    }
+
+    if(nodeIndex == 0 && GetImportance(nodes[0].bounds, point, normal) <= 0.f)
+    {
+        return 0.f;
+    }
+
+    return probability;
+}
@@ -0,0 +1,76 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#ifndef __LIGHTBVH_H__
+#define __LIGHTBVH_H__
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Light.h"
+#include "Math.h"
+
+// Lights drawn from the light BVH per shading point
+#define DEFAULT_LIGHT_BVH_SAMPLE_COUNT 1
+
+// Split candidates per axis while building
+#define LIGHT_BVH_BUCKET_COUNT 12
+
+// A light a point is shaded with
+struct LightSelection
+{
+    unsigned int lightIndex;
+
+    // Expected number of times the light is picked for the point, 1 when every light is shaded with
+    float probability;
+};
+
+/*
+    Light hierarchy over the scene's lights
+    Nodes hold the bounds, emission cones and power of their lights, so a light is picked proportional to its estimated contribution in logarithmic time
+    Lights without a position are left out, they are shaded with at every point
+*/
+class LightBVH
+{
+public:
+    void Build(const std::vector<Light *> &lights);
+
+    // Picks a light proportional to its importance at the point with the normal, returns false when no light lights the point
+    bool Sample(const Vector3 &point, const Vector3 &normal, float u, unsigned int &lightIndex, float &probability) const;
+
+    // Probability of Sample picking the light at the point with the normal
+    float GetProbability(const Vector3 &point, const Vector3 &normal, const Light *light) const;
+
+    // Indices of the lights left out of the hierarchy
+    inline const std::vector<unsigned int> &GetUnboundedLights() const
+    {
+        return unboundedLights;
+    }
+
+private:
+    struct Node
+    {
+        LightBounds bounds;
+
+        // Light index of a leaf, second child of an interior node, its first child follows it
+        unsigned int index;
+        bool isLeaf;
+    };
+
+    typedef std::pair<unsigned int, LightBounds> BoundedLight;
+
+    // Appends the subtree of the lights in [begin, end) to the nodes, bitTrail is the path from the root to it
+    void BuildNode(const std::vector<Light *> &sceneLights, std::vector<BoundedLight> &lights, size_t begin, size_t end, uint64_t bitTrail, unsigned int depth);
+
+    std::vector<Node> nodes;
+    std::vector<unsigned int> unboundedLights;
+
+    // Path from the root to every light's leaf, a set bit at a depth takes the second child
+    std::unordered_map<const Light *, uint64_t> bitTrails;
+};
+
+#endif
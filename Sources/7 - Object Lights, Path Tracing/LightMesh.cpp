@@ -6,29 +6,166 @@
 
 #include "LightMesh.h"
 
+#include <map>
+
 #include "RandomGenerator.h"
 #include "Scene.h"
 
+// Area weighted like the stratified samples, so every point of the mesh is equally likely
 Vector3 LightMesh::GetPosition() const
 {
-    unsigned int randomValue = RandomGenerator::GetRandomUInt(faces.size());
-    
-    Face *randomFace = faces[randomValue];
+    float u = RandomGenerator::GetRandomFloat();
+    float v = RandomGenerator::GetRandomFloat();
+
+    Vector3 lightNormal;
+    return SamplePosition(u, v, lightNormal);
+}
+
+// u picks the face proportional to its area, its remainder is reused as the first barycentric number
+Vector3 LightMesh::SamplePosition(float u, float v, Vector3 &lightNormal) const
+{
+    float faceU;
+    unsigned int faceIndex = faceTable.Sample(u, faceU);
+
+    const Vector3 &A = worldVertices[faceIndex * 3];
+    const Vector3 &B = worldVertices[faceIndex * 3 + 1];
+    const Vector3 &C = worldVertices[faceIndex * 3 + 2];
+
+    lightNormal = worldNormals[faceIndex];
+
+    Vector3 q = (1 - faceU) * B + faceU * C;
+    float sqrtV = sqrt(v);
+
+    return (1 - sqrtV) * A + sqrtV * q;
+}
+
+// Every point of the mesh is equally likely, so the area density is one over the area
+// A closed mesh hides the faces turned away from positionAt, their points have no density there
+float LightMesh::GetPdf(const Vector3 &lightPosition, const Vector3 &lightNormal, const Vector3 &positionAt) const
+{
+    Vector3 toLight = lightPosition - positionAt;
+    float squaredDistance = Vector3::Dot(toLight, toLight);
+    float cosLight = -Vector3::Dot(lightNormal, toLight) / sqrt(squaredDistance);
+
+    if(!isClosed)
+    {
+        cosLight = std::fabs(cosLight);
+    }
+
+    if(cosLight <= 0.f || area <= 0.f)
+    {
+        return 0.f;
+    }
+
+    return squaredDistance / (cosLight * area);
+}
+
+void LightMesh::PrepareSampling()
+{
+    worldVertices.resize(faces.size() * 3);
+    worldNormals.resize(faces.size());
+
+    std::vector<float> faceAreas(faces.size());
+    area = 0.f;
+
+    // Faces using every edge, by the edge's vertex indices
+    std::map<std::pair<unsigned int, unsigned int>, unsigned int> edgeUses;
+    Matrix normalMatrix = inverseTransformationMatrix.GetTranspose().GetUpper3x3();
+
+    for(size_t faceIndex = 0; faceIndex < faces.size(); faceIndex++)
+    {
+        const Face *face = faces[faceIndex];
+
+        Vector3 A = Vector3(transformationMatrix * Vector4(mainScene->vertices[face->v0 - 1], 1.f));
+        Vector3 B = Vector3(transformationMatrix * Vector4(mainScene->vertices[face->v1 - 1], 1.f));
+        Vector3 C = Vector3(transformationMatrix * Vector4(mainScene->vertices[face->v2 - 1], 1.f));
+
+        worldVertices[faceIndex * 3] = A;
+        worldVertices[faceIndex * 3 + 1] = B;
+        worldVertices[faceIndex * 3 + 2] = C;
+
+        Vector3 faceNormal = Vector3::Cross(C - B, A - B);
+        float faceNormalLength = faceNormal.Length();
+
+        // Turned like the normal the faces are hit from the front of, a mirroring transformation flips the winding
+        if(Vector3::Dot(faceNormal, Vector3(normalMatrix * Vector4(face->normal, 0.f))) < 0.f)
+        {
+            faceNormal = -faceNormal;
+        }
+
+        worldNormals[faceIndex] = faceNormalLength > 0.f ? faceNormal / faceNormalLength : Vector3::ZeroVector;
+
+        faceAreas[faceIndex] = faceNormalLength * 0.5f;
+        area += faceAreas[faceIndex];
+
+        unsigned int corners[3] = { face->v0, face->v1, face->v2 };
+
+        for(unsigned int cornerIndex = 0; cornerIndex < 3; cornerIndex++)
+        {
+            unsigned int first = corners[cornerIndex];
+            unsigned int second = corners[(cornerIndex + 1) % 3];
+            edgeUses[std::make_pair(mathMin(first, second), mathMax(first, second))]++;
+        }
+    }
+
+    faceTable.Build(faceAreas);
+
+    isClosed = !edgeUses.empty();
+
+    for(const auto &edgeUse : edgeUses)
+    {
+        if(edgeUse.second != 2)
+        {
+            isClosed = false;
+            break;
+        }
+    }
+}
+
+bool LightMesh::GetBounds(LightBounds &bounds) const
+{
+    if(faceTable.IsEmpty())
+    {
+        return false;
+    }
+
+    bounds = GetPointBounds(worldVertices[0], GetMaxIntensity() * area);
+
+    Vector3 planeNormal = Vector3::ZeroVector;
+    bool isPlanar = true;
+
+    for(size_t faceIndex = 0; faceIndex < faces.size(); faceIndex++)
+    {
+        ExtendBounds(bounds, worldVertices[faceIndex * 3]);
+        ExtendBounds(bounds, worldVertices[faceIndex * 3 + 1]);
+        ExtendBounds(bounds, worldVertices[faceIndex * 3 + 2]);
+
+        const Vector3 &faceNormal = worldNormals[faceIndex];
 
-    float randomValue1 = RandomGenerator::GetRandomFloat();
-    float randomValue2 = RandomGenerator::GetRandomFloat();
-    
-    Vector3 A = mainScene->vertices[randomFace->v0 - 1];
-    Vector3 B = mainScene->vertices[randomFace->v1 - 1];
-    Vector3 C = mainScene->vertices[randomFace->v2 - 1];
+        if(faceNormal == Vector3::ZeroVector)
+        {
+            continue;
+        }
 
-    Vector3 q = (1 - randomValue1) * B + randomValue1 * C;
-    float sqrtRandomValue2 = sqrt(randomValue2);
-    Vector3 p = (1 - sqrtRandomValue2) * A + sqrtRandomValue2 * q;
+        if(planeNormal == Vector3::ZeroVector)
+        {
+            planeNormal = faceNormal;
+        }
+        else if(std::fabs(Vector3::Dot(planeNormal, faceNormal)) < 1.f - EPSILON)
+        {
+            isPlanar = false;
+        }
+    }
 
-    p = Vector3(transformationMatrix * Vector4(p, 1.f));
+    // Faces are lit from both sides, so a plane emits around both of its normals
+    if(isPlanar && planeNormal != Vector3::ZeroVector)
+    {
+        bounds.axis = planeNormal;
+        bounds.cosThetaO = 1.f;
+        bounds.twoSided = true;
+    }
 
-    return p;
+    return true;
 }
 
 Vector3 LightMesh::GetIntensityAtPosition(const Vector3& lightPosition, const Vector3& positionAt) const
@@ -7,6 +7,7 @@
 #ifndef __LIGHTMESH_H__
 #define __LIGHTMESH_H__
 
+#include "AliasTable.h"
 #include "PointLight.h"
 #include "Mesh.h"
 
@@ -15,7 +16,7 @@ class LightMesh : public Light, public Mesh
 public:
     LightMesh() : Light(), Mesh()
     {
-
+        castsShadows = false;
     }
 
     ~LightMesh()
@@ -29,13 +30,35 @@ public:
     }
 
     Vector3 GetPosition() const override;
+    Vector3 SamplePosition(float u, float v, Vector3 &lightNormal) const override;
+    float GetPdf(const Vector3 &lightPosition, const Vector3 &lightNormal, const Vector3 &positionAt) const override;
+
+    bool IsEmissiveGeometry() const override
+    {
+        return true;
+    }
     
     Vector3 GetIntensityAtPosition(const Vector3& lightPosition, const Vector3& positionAt) const override;
 
+    // Planar meshes emit around their normal, any other mesh to every direction
+    bool GetBounds(LightBounds &bounds) const override;
+
+    // Transforms the faces to world space and builds their area distribution, called once the faces and the transformation are set
+    void PrepareSampling();
+
     //Vector3 radiance;
 
 private:
+    // Face corners in world space, three per face
+    std::vector<Vector3> worldVertices;
+    std::vector<Vector3> worldNormals;
+
+    // Picks the faces proportional to their world space areas
+    AliasTable faceTable;
+    float area = 0.f;
 
+    // Every edge is shared by two faces, so only the faces whose normals point to a position can be seen from it
+    bool isClosed = false;
 };
 
 #endif
\ No newline at end of file
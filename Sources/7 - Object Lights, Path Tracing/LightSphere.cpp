@@ -27,6 +27,78 @@ Vector3 LightSphere::GetPosition() const
     return Vector3(transformationMatrix * Vector4(lightPosition, 1.f));
 }
 
+// Uniform point on the sphere, z is uniform in [-1, 1] by Archimedes' theorem
+Vector3 LightSphere::SamplePosition(float u, float v, Vector3 &lightNormal) const
+{
+    float z = 1.f - 2.f * u;
+    float r = sqrt(mathMax(0.f, 1.f - z * z));
+    float phi = TWO_PI * v;
+
+    Vector3 localNormal(r * cos(phi), r * sin(phi), z);
+
+    lightNormal = Vector3(normalMatrix * Vector4(localNormal, 0.f)).GetNormalized();
+
+    Vector3 lightPosition = localNormal * radius;
+    lightPosition += center;
+
+    return Vector3(transformationMatrix * Vector4(lightPosition, 1.f));
+}
+
+// Points are uniform on the untransformed sphere, the transformation scales the area around each one differently
+// The far side of the sphere cannot be seen from positionAt, its points have no density there
+float LightSphere::GetPdf(const Vector3 &lightPosition, const Vector3 &lightNormal, const Vector3 &positionAt) const
+{
+    Vector3 localNormal = (Vector3(inverseTransformationMatrix * Vector4(lightPosition, 1.f)) - center) / radius;
+    float areaScale = std::fabs(determinant) * Vector3(normalMatrix * Vector4(localNormal, 0.f)).Length();
+
+    Vector3 toLight = lightPosition - positionAt;
+    float squaredDistance = Vector3::Dot(toLight, toLight);
+    float cosLight = -Vector3::Dot(lightNormal, toLight) / sqrt(squaredDistance);
+
+    if(cosLight <= 0.f || areaScale <= 0.f)
+    {
+        return 0.f;
+    }
+
+    return squaredDistance / (cosLight * 2.f * TWO_PI * radius * radius * areaScale);
+}
+
+// The transformed box of the untransformed sphere holds the transformed sphere
+bool LightSphere::GetBounds(LightBounds &bounds) const
+{
+    // Transformation scales the surface by about the volume scale to the power of two thirds
+    float surfaceArea = 2.f * TWO_PI * radius * radius * pow(std::fabs(determinant), 2.f / 3.f);
+
+    for(unsigned int cornerIndex = 0; cornerIndex < 8; cornerIndex++)
+    {
+        Vector3 corner = center + Vector3(cornerIndex & 1 ? radius : -radius,
+                                          cornerIndex & 2 ? radius : -radius,
+                                          cornerIndex & 4 ? radius : -radius);
+        corner = Vector3(transformationMatrix * Vector4(corner, 1.f));
+
+        if(cornerIndex == 0)
+        {
+            bounds = GetPointBounds(corner, GetMaxIntensity() * surfaceArea);
+        }
+        else
+        {
+            ExtendBounds(bounds, corner);
+        }
+    }
+
+    return true;
+}
+
+void LightSphere::PrepareSampling()
+{
+    normalMatrix = inverseTransformationMatrix.GetTranspose().GetUpper3x3();
+
+    const float *m = transformationMatrix.m;
+    determinant = m[0] * (m[5] * m[10] - m[6] * m[9])
+                - m[1] * (m[4] * m[10] - m[6] * m[8])
+                + m[2] * (m[4] * m[9] - m[5] * m[8]);
+}
+
 Vector3 LightSphere::GetIntensityAtPosition(const Vector3& lightPosition, const Vector3& positionAt) const
 {
     float distance = (lightPosition - positionAt).Length();
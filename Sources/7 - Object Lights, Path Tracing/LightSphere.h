@@ -15,7 +15,7 @@ class LightSphere : public Light, public Sphere
 public:
     LightSphere()
     {
-
+        castsShadows = false;
     }
 
     ~LightSphere()
@@ -24,11 +24,24 @@ public:
     }
 
     Vector3 GetPosition() const;
+    Vector3 SamplePosition(float u, float v, Vector3 &lightNormal) const override;
+    float GetPdf(const Vector3 &lightPosition, const Vector3 &lightNormal, const Vector3 &positionAt) const override;
+
+    bool IsEmissiveGeometry() const override
+    {
+        return true;
+    }
 
     Vector3 GetIntensityAtPosition(const Vector3& lightPosition, const Vector3& positionAt) const override;
+
+    bool GetBounds(LightBounds &bounds) const override;
+
+    // Caches the transformation's normal matrix and volume scale, called once the transformation is set
+    void PrepareSampling();
     
 private:
-
+    Matrix normalMatrix;
+    float determinant = 1.f;
 };
 
 #endif
\ No newline at end of file
@@ -12,17 +12,41 @@
 #include <stdexcept>
 
 #include <limits>
+#include <type_traits>
 
-#define mathMax(f, s) (f > s ? f : s)
-#define mathMin(f, s) (f > s ? s : f)
-#define mathClamp(value, min, max) (value > max ? max : value < min ? min : value)
-#define mathAbs(value) (value < 0 ? value * -1 : value)
+// Arguments are evaluated once and mixed argument types are promoted like in the conditional operator
+template <typename F, typename S>
+constexpr inline typename std::common_type<F, S>::type mathMax(F f, S s)
+{
+  return f > s ? f : s;
+}
+
+template <typename F, typename S>
+constexpr inline typename std::common_type<F, S>::type mathMin(F f, S s)
+{
+  return f > s ? s : f;
+}
 
-#define PI 3.14159265359
-#define TWO_PI 6.28318530718
-#define HALF_PI 1.57079632679
-#define ONE_OVER_PI 0.31830988618
-#define NATURAL_LOGARITHM 2.71828182845
+// Compared in the common type, so unsigned values can be clamped to signed literals
+template <typename T, typename Min, typename Max>
+constexpr inline typename std::common_type<T, Min, Max>::type mathClamp(T value, Min min, Max max)
+{
+  typedef typename std::common_type<T, Min, Max>::type Common;
+  return Common(value) > Common(max) ? Common(max) : Common(value) < Common(min) ? Common(min) : Common(value);
+}
+
+template <typename T>
+constexpr inline T mathAbs(T value)
+{
+  return value < 0 ? -value : value;
+}
+
+// Single precision, so that float expressions are not promoted to double
+#define PI 3.14159265359f
+#define TWO_PI 6.28318530718f
+#define HALF_PI 1.57079632679f
+#define ONE_OVER_PI 0.31830988618f
+#define NATURAL_LOGARITHM 2.71828182845f
 
 #define RADIAN_TO_DEGREE(radian) (radian * 180 / PI)
 #define DEGREE_TO_RADIAN(degree) (degree * PI / 180)
@@ -65,7 +89,7 @@ struct Vector2
 
   inline float Length() const
   {
-    return sqrt(std::pow(x, 2) + std::pow(y, 2));
+    return sqrtf(x * x + y * y);
   }
 
   static inline Vector2 Cross(const Vector2& v1, const Vector2& v2)
@@ -183,6 +207,7 @@ struct Vector2
 
   Vector2 GetOrthonormalBasis() const 
   {
+    return Vector2(-y, x).GetNormalized();
   }
 
   static const Vector2 ZeroVector;
@@ -229,7 +254,12 @@ struct Vector3
 
   inline float Length() const
   {
-    return sqrt(std::pow(x, 2) + std::pow(y, 2) + std::pow(z, 2));
+    return sqrtf(x * x + y * y + z * z);
+  }
+
+  inline float GetMaxComponent() const
+  {
+    return mathMax(x, mathMax(y, z));
   }
 
   static inline Vector3 Cross(const Vector3& v1, const Vector3& v2)
@@ -312,11 +342,12 @@ struct Vector3
     return Vector3(x * val, y * val, z * val);
   }
 
-  inline Vector3 operator*=(float val)
+  inline Vector3& operator*=(float val)
   {
     x *= val;
     y *= val;
     z *= val;
+    return *this;
   }
 
   inline friend Vector3 operator*(float val, const Vector3& rhs)
@@ -178,7 +178,7 @@ Matrix Matrix::GetTranspose() const
     out.m[11] = m[14];
 
     out.m[12] = m[3];
-    out.m[13] = m[5];
+    out.m[13] = m[7];
     out.m[14] = m[11];
     out.m[15] = m[15];
 
@@ -8,6 +8,7 @@
 #define __MATRIX_H__
 
 #include "Math.h"
+#include "SIMD.h"
 
 /*
     Matrix2x2 IS NOT TESTED!!!
@@ -206,41 +207,52 @@ public:
         }
     }
 
+    // Sum of the columns scaled by the vector components, every lane adds in the same order as the row dot product
     Vector4 operator*(const Vector4& rhs) const
     {
-        Vector4 out(0);
+        Float4 out = Float4(m[0], m[4], m[8], m[12]) * Float4(rhs.x)
+                   + Float4(m[1], m[5], m[9], m[13]) * Float4(rhs.y)
+                   + Float4(m[2], m[6], m[10], m[14]) * Float4(rhs.z)
+                   + Float4(m[3], m[7], m[11], m[15]) * Float4(rhs.w);
 
-        out.x = m[0] * rhs.x + m[1] * rhs.y + m[2] * rhs.z + m[3] * rhs.w;
-        out.y = m[4] * rhs.x + m[5] * rhs.y + m[6] * rhs.z + m[7] * rhs.w;
-        out.z = m[8] * rhs.x + m[9] * rhs.y + m[10] * rhs.z + m[11] * rhs.w;
-        out.w = m[12] * rhs.x + m[13] * rhs.y + m[14] * rhs.z + m[15] * rhs.w;
+        float values[4];
+        out.Store(values);
 
-        return out;
+        return Vector4(values[0], values[1], values[2], values[3]);
     }
 
-    Matrix operator*(const Matrix& rhs) const
+    // Packet versions of the products with Vector4(point, 1) and Vector4(direction, 0), lanes add in the same order as the Vector4 product
+    template <typename Float>
+    Vector3xN<Float> TransformPoint(const Vector3xN<Float> &point) const
     {
-        Matrix out(0.f);
+        return Transform(point, Float(1.f));
+    }
 
-        out.m[0] = m[0] * rhs.m[0] + m[1] * rhs.m[4] + m[2] * rhs.m[8] + m[3] * rhs.m[12];
-        out.m[1] = m[0] * rhs.m[1] + m[1] * rhs.m[5] + m[2] * rhs.m[9] + m[3] * rhs.m[13];
-        out.m[2] = m[0] * rhs.m[2] + m[1] * rhs.m[6] + m[2] * rhs.m[10] + m[3] * rhs.m[14];
-        out.m[3] = m[0] * rhs.m[3] + m[1] * rhs.m[7] + m[2] * rhs.m[11] + m[3] * rhs.m[15];
+    template <typename Float>
+    Vector3xN<Float> TransformDirection(const Vector3xN<Float> &direction) const
+    {
+        return Transform(direction, Float(0.f));
+    }
 
-        out.m[4] = m[4] * rhs.m[0] + m[5] * rhs.m[4] + m[6] * rhs.m[8] + m[7] * rhs.m[12];
-        out.m[5] = m[4] * rhs.m[1] + m[5] * rhs.m[5] + m[6] * rhs.m[9] + m[7] * rhs.m[13];
-        out.m[6] = m[4] * rhs.m[2] + m[5] * rhs.m[6] + m[6] * rhs.m[10] + m[7] * rhs.m[14];
-        out.m[7] = m[4] * rhs.m[3] + m[5] * rhs.m[7] + m[6] * rhs.m[11] + m[7] * rhs.m[15];
+    // Row i of the result is the rhs rows scaled by row i of this matrix
+    Matrix operator*(const Matrix& rhs) const
+    {
+        Float4 rhsRow0 = Float4::Load(rhs.m);
+        Float4 rhsRow1 = Float4::Load(rhs.m + 4);
+        Float4 rhsRow2 = Float4::Load(rhs.m + 8);
+        Float4 rhsRow3 = Float4::Load(rhs.m + 12);
 
-        out.m[8] = m[8] * rhs.m[0] + m[9] * rhs.m[4] + m[10] * rhs.m[8] + m[11] * rhs.m[12];
-        out.m[9] = m[8] * rhs.m[1] + m[9] * rhs.m[5] + m[10] * rhs.m[9] + m[11] * rhs.m[13];
-        out.m[10] = m[8] * rhs.m[2] + m[9] * rhs.m[6] + m[10] * rhs.m[10] + m[11] * rhs.m[14];
-        out.m[11] = m[8] * rhs.m[3] + m[9] * rhs.m[7] + m[10] * rhs.m[11] + m[11] * rhs.m[15];
+        Matrix out;
 
-        out.m[12] = m[12] * rhs.m[0] + m[13] * rhs.m[4] + m[14] * rhs.m[8] + m[15] * rhs.m[12];
-        out.m[13] = m[12] * rhs.m[1] + m[13] * rhs.m[5] + m[14] * rhs.m[9] + m[15] * rhs.m[13];
-        out.m[14] = m[12] * rhs.m[2] + m[13] * rhs.m[6] + m[14] * rhs.m[10] + m[15] * rhs.m[14];
-        out.m[15] = m[12] * rhs.m[3] + m[13] * rhs.m[7] + m[14] * rhs.m[11] + m[15] * rhs.m[15];
+        for(int row = 0; row < 16; row += 4)
+        {
+            Float4 outRow = Float4(m[row]) * rhsRow0
+                          + Float4(m[row + 1]) * rhsRow1
+                          + Float4(m[row + 2]) * rhsRow2
+                          + Float4(m[row + 3]) * rhsRow3;
+
+            outRow.Store(out.m + row);
+        }
 
         return out;
     }
@@ -279,6 +291,15 @@ public:
     static const Matrix IdentityMatrix;
 
     float m[16];
+
+private:
+    template <typename Float>
+    Vector3xN<Float> Transform(const Vector3xN<Float> &v, const Float &w) const
+    {
+        return Vector3xN<Float>(Float(m[0]) * v.x + Float(m[1]) * v.y + Float(m[2]) * v.z + Float(m[3]) * w,
+                                Float(m[4]) * v.x + Float(m[5]) * v.y + Float(m[6]) * v.z + Float(m[7]) * w,
+                                Float(m[8]) * v.x + Float(m[9]) * v.y + Float(m[10]) * v.z + Float(m[11]) * w);
+    }
 };
 
 
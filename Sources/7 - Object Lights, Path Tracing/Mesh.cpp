@@ -42,7 +42,8 @@ bool Face::Intersection(const Ray &ray, float &t, Vector3& n, float &hitBeta, fl
     float gamma = Math::Determinant(aMinusB, aMinusE, ray.dir) / detA;
     t = Math::Determinant(aMinusB, aMinusC, aMinusE) / detA;
 
-    if (   t > 0
+    if (   t > ray.tMin
+        && t < ray.tMax
         && 0 <= beta
         && 0 <= gamma
         && beta + gamma <= 1)
@@ -187,28 +188,35 @@ void Face::GetBoundingVolumePositions(Vector3 &min, Vector3 &max)
 
 bool Mesh::Intersection(const Ray &ray, float& t, Vector3& n, float &beta, float &gamma, const ObjectBase ** hitObject, bool shadowCheck) const
 {
-    Vector4 transformatedE = inverseTransformationMatrix * Vector4(ray.e, 1.f);
-    Vector4 transformatedDir = inverseTransformationMatrix * Vector4(ray.dir, 0.f);
-
     unsigned int faceCount = faces.size();
 
     float outT = MAX_FLOAT;
     bool out = false;
 
+    // The scene has already moved the ray into the object space
+    Ray objectRay(ray.e, ray.dir, ray.tMin, ray.tMax);
+    const ObjectBase *faceObject;
+
     for(unsigned int faceIndex = 0; faceIndex < faceCount; faceIndex++)
     {
         Face *currFace = faces[faceIndex];
 
-        float iteT;
+        float iteT, iteBeta, iteGamma;
         Vector3 iteN;
-        if(currFace->Intersection(Ray(transformatedE, transformatedDir), iteT, iteN, beta, gamma, hitObject, shadowCheck))
+        if(currFace->Intersection(objectRay, iteT, iteN, iteBeta, iteGamma, &faceObject, shadowCheck))
         {        
-            if(outT > iteT && iteT > 0)
+            if(outT > iteT)
             {
                 out = true;
                 outT = iteT;
-                n = currFace->normal;
-                *hitObject = this;
+                n = iteN;
+                beta = iteBeta;
+                gamma = iteGamma;
+
+                // Report the face like the BVH does, it holds the material and the parent mesh
+                *hitObject = faceObject;
+
+                objectRay.tMax = iteT;
             }
         }
     }
@@ -262,7 +270,7 @@ bool MeshInstance::Intersection(const Ray &ray, float &t, Vector3& n, float &bet
     Vector4 transformatedE = inverseTransformationMatrix * Vector4(ray.e, 1.f);
     Vector4 transformatedDir = inverseTransformationMatrix * Vector4(ray.dir, 0.f);
 
-    return baseMesh->Intersection(Ray(transformatedE, transformatedDir), t, n, beta, gamma, hitObject, shadowCheck);
+    return baseMesh->Intersection(Ray(transformatedE, transformatedDir, ray.tMin, ray.tMax), t, n, beta, gamma, hitObject, shadowCheck);
 }
 
 void MeshInstance::CreateBVH()
@@ -4,4 +4,29 @@
  *	2018
  */
 
-#include "ObjectBase.h"
\ No newline at end of file
+#include "ObjectBase.h"
+
+bool ObjectBase::OcclusionIntersection(const Ray &ray) const
+{
+    float t = 0.f, beta, gamma;
+    Vector3 n;
+    const ObjectBase *hitObject = nullptr;
+
+    return Intersection(ray, t, n, beta, gamma, &hitObject, true);
+}
+
+Mask8 ObjectBase::OcclusionIntersection(const RayPacket8 &packet, const Mask8 &active) const
+{
+    int activeBits = active.GetBits();
+    int hitBits = 0;
+
+    for(int lane = 0; lane < RayPacket8::Width; lane++)
+    {
+        if(((activeBits >> lane) & 1) && OcclusionIntersection(packet.GetLane(lane)))
+        {
+            hitBits |= 1 << lane;
+        }
+    }
+
+    return Mask8::FromBits(hitBits);
+}
\ No newline at end of file
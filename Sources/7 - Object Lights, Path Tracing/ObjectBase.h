@@ -59,6 +59,12 @@ public:
 
     virtual bool Intersection(const Ray &ray, float &t, Vector3& n, float &beta, float &gamma, const ObjectBase ** hitObject, bool shadowCheck = false) const = 0;
 
+    // Returns true when the ray hits the object within its valid interval, the hit does not have to be the closest one
+    virtual bool OcclusionIntersection(const Ray &ray) const;
+
+    // Packet version, returns the active lanes that hit the object, the lanes are tested one by one unless it is overridden
+    virtual Mask8 OcclusionIntersection(const RayPacket8 &packet, const Mask8 &active) const;
+
     virtual void GetIntersectingUV(const Vector3 &intersectionPoint, float beta, float gamma, float &u, float &v) const
     {
 
@@ -89,6 +95,9 @@ public:
 
     ObjectBase *parentObject = nullptr;
 
+    // Emitting objects are skipped by the shadow rays
+    bool castsShadows = true;
+
     unsigned int vertexOffset = 0;
     unsigned int textureOffset = 0;
 
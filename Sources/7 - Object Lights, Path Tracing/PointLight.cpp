@@ -12,4 +12,10 @@ Vector3 PointLight::GetIntensityAtPosition(const Vector3& lightPosition, const V
 
     // Inverse square law
     return intensity / (distance * distance);
+}
+
+bool PointLight::GetBounds(LightBounds &bounds) const
+{
+    bounds = GetPointBounds(position, GetMaxIntensity());
+    return true;
 }
\ No newline at end of file
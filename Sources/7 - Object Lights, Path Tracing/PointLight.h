@@ -23,6 +23,8 @@ public:
     }
     
     Vector3 GetIntensityAtPosition(const Vector3& lightPosition, const Vector3& positionAt) const override;
+
+    bool GetBounds(LightBounds &bounds) const override;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,129 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#include "ProgressReporter.h"
+
+#include <iomanip>
+#include <iostream>
+
+ProgressReporter::Counters ProgressReporter::counters[PROGRESS_MAX_SLOTS];
+std::atomic<unsigned int> ProgressReporter::nextSlot(0);
+thread_local ProgressReporter::Counters *ProgressReporter::threadCounters = nullptr;
+
+std::thread ProgressReporter::reporterThread;
+std::mutex ProgressReporter::mutex;
+std::condition_variable ProgressReporter::stopCondition;
+bool ProgressReporter::stopping = false;
+
+uint64_t ProgressReporter::totalPixelCount = 0;
+float ProgressReporter::interval = DEFAULT_PROGRESS_INTERVAL;
+std::chrono::steady_clock::time_point ProgressReporter::startTime;
+
+void ProgressReporter::Start(uint64_t totalPixelCount, float intervalSeconds)
+{
+    // Nothing is rendering yet, so the counters can be cleared without synchronization
+    for(auto &slot : counters)
+    {
+        slot.pixels.store(0, std::memory_order_relaxed);
+        slot.rays.store(0, std::memory_order_relaxed);
+    }
+
+    ProgressReporter::totalPixelCount = totalPixelCount;
+    interval = intervalSeconds;
+    stopping = false;
+    startTime = std::chrono::steady_clock::now();
+
+    if(interval > 0.f)
+    {
+        reporterThread = std::thread(&ProgressReporter::ReporterFunction);
+    }
+}
+
+void ProgressReporter::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    stopCondition.notify_one();
+
+    if(reporterThread.joinable())
+    {
+        reporterThread.join();
+    }
+
+    uint64_t pixels, rays;
+    GetTotals(pixels, rays);
+
+    double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+
+    std::cout << "\rRendered " << pixels << " pixels, traced " << rays << " rays in " << std::fixed << std::setprecision(2) << elapsedSeconds
+              << " seconds, " << (elapsedSeconds > 0.0 ? rays / elapsedSeconds * 1e-6 : 0.0) << " Mrays/s." << std::endl;
+
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
+
+void ProgressReporter::ReporterFunction()
+{
+    std::chrono::duration<float> waitDuration(interval);
+
+    uint64_t previousRays = 0;
+    std::chrono::steady_clock::time_point previousTime = startTime;
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while(!stopCondition.wait_for(lock, waitDuration, []{ return stopping; }))
+    {
+        uint64_t pixels, rays;
+        GetTotals(pixels, rays);
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double elapsedSeconds = std::chrono::duration<double>(now - startTime).count();
+        double intervalSeconds = std::chrono::duration<double>(now - previousTime).count();
+
+        double progress = totalPixelCount > 0 ? (double)pixels / totalPixelCount : 0.0;
+        double rayRate = intervalSeconds > 0.0 ? (rays - previousRays) / intervalSeconds : 0.0;
+
+        std::ios_base::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
+
+        std::cout << "\r" << std::fixed << std::setprecision(1) << progress * 100.0 << "% | " << elapsedSeconds << " s elapsed | ETA ";
+
+        if(progress > 0.0)
+        {
+            std::cout << elapsedSeconds * (1.0 - progress) / progress << " s";
+        }
+        else
+        {
+            std::cout << "-";
+        }
+
+        std::cout << " | " << std::setprecision(2) << rayRate * 1e-6 << " Mrays/s   " << std::flush;
+
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+
+        previousRays = rays;
+        previousTime = now;
+    }
+}
+
+void ProgressReporter::GetTotals(uint64_t &pixels, uint64_t &rays)
+{
+    pixels = 0;
+    rays = 0;
+
+    for(auto &slot : counters)
+    {
+        pixels += slot.pixels.load(std::memory_order_relaxed);
+        rays += slot.rays.load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#ifndef __PROGRESSREPORTER_H__
+#define __PROGRESSREPORTER_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#define DEFAULT_PROGRESS_INTERVAL 1.f
+
+// Threads beyond this share counter slots, which is still correct but no longer contention free
+#define PROGRESS_MAX_SLOTS 256
+
+/*
+    Static progress reporter
+    Render threads only add to counters of their own, a reporter thread sums them up at a low frequency
+    and prints the progress, the remaining time and the ray throughput
+*/
+class ProgressReporter
+{
+public:
+    // Starts a report for totalPixelCount pixels
+    // A positive interval prints the progress every interval seconds, otherwise only the summary is printed
+    static void Start(uint64_t totalPixelCount, float intervalSeconds);
+
+    // Stops the reporter thread and prints the summary
+    static void Stop();
+
+    static inline void AddPixels(uint64_t count)
+    {
+        GetThreadCounters().pixels.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    static inline void AddRays(uint64_t count)
+    {
+        GetThreadCounters().rays.fetch_add(count, std::memory_order_relaxed);
+    }
+
+private:
+    // Counters of a thread, each on its own cache line
+    struct alignas(64) Counters
+    {
+        std::atomic<uint64_t> pixels;
+        std::atomic<uint64_t> rays;
+    };
+
+    static inline Counters &GetThreadCounters()
+    {
+        if(threadCounters == nullptr)
+        {
+            threadCounters = &counters[nextSlot.fetch_add(1, std::memory_order_relaxed) % PROGRESS_MAX_SLOTS];
+        }
+
+        return *threadCounters;
+    }
+
+    static void ReporterFunction();
+
+    // Sums the counters of all threads
+    static void GetTotals(uint64_t &pixels, uint64_t &rays);
+
+    static Counters counters[PROGRESS_MAX_SLOTS];
+    static std::atomic<unsigned int> nextSlot;
+    static thread_local Counters *threadCounters;
+
+    static std::thread reporterThread;
+    static std::mutex mutex;
+    static std::condition_variable stopCondition;
+    static bool stopping;
+
+    static uint64_t totalPixelCount;
+    static float interval;
+    static std::chrono::steady_clock::time_point startTime;
+};
+
+#endif
@@ -6,28 +6,51 @@
 
 #include "RandomGenerator.h"
 
-#include <random>
+#include <cmath>
 
 #include "Math.h"
 
-std::random_device randomDevice;  //Will be used to obtain a seed for the random number engine
-std::mt19937 randomGenerator(randomDevice()); //Standard mersenne_twister_engine seeded with randomDevice()
-std::uniform_real_distribution<float> uniformDistribution(0.0f, 1.0f);
-std::normal_distribution<float> gaussianDistribution(0.0f, 1.0f);
+constexpr uint64_t PCG32::PCG32_MULTIPLIER;
+constexpr uint64_t PCG32::PCG32_INCREMENT;
 
-std::uniform_int_distribution<unsigned int> uniformIntDistribution;
-std::uniform_int_distribution<unsigned int> uniformUnsignedIntDistribution;
+const Sampler *RandomGenerator::sampler = nullptr;
+thread_local SampleState RandomGenerator::sampleState;
 
-// Return random value in [0, 1]
-float RandomGenerator::GetRandomFloat()
+// SplitMix64 finalizer, spreads neighbouring pixel and sample indices over the whole state space
+static inline uint64_t MixBits(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+void RandomGenerator::SetSampler(SAMPLER_TYPE type)
+{
+    sampler = Sampler::GetSampler(type);
+}
+
+void RandomGenerator::StartSample(uint32_t pixelIndex, uint32_t sampleIndex, uint32_t frameIndex)
 {
-    return uniformDistribution(randomGenerator);
+    uint64_t key = ((uint64_t)pixelIndex << 32) | sampleIndex;
+    sampleState.generator.state = MixBits(key ^ MixBits(frameIndex + 1));
+
+    // Step once so the first output already depends on every bit of the seed
+    sampleState.generator.NextUInt();
+
+    // Samples of a pixel share the seed, so they form one point set
+    sampleState.pixelSeed = (uint32_t)MixBits(((uint64_t)frameIndex << 32) | pixelIndex);
+    sampleState.sampleIndex = sampleIndex;
+    sampleState.dimension = SAMPLE_FIRST_PATH_DIMENSION;
 }
 
 // Return random value in [0, 1]
 float RandomGenerator::GetGaussianRandomFloat()
 {
-    return gaussianDistribution(randomGenerator);
+    // Box-Muller transform, 1 - u keeps the logarithm finite
+    float u = 1.f - sampleState.generator.NextFloat();
+    float v = sampleState.generator.NextFloat();
+
+    return sqrtf(-2.f * logf(u)) * cosf(TWO_PI * v);
 }
 
 // Return random value in [0, max]
@@ -57,7 +80,7 @@ float RandomGenerator::GetGaussianRandomFloat(float min, float max)
 // Return random value in [-MAX_INT, MAX_INT]
 int RandomGenerator::GetRandomInt()
 {
-    return uniformIntDistribution(randomGenerator);
+    return (int)sampleState.generator.NextUInt();
 }
 
 // Return random value in [0, max]
@@ -76,7 +99,7 @@ int RandomGenerator::GetRandomInt(int min, int max)
 // Return random value in [0, MAX_INT]
 unsigned int RandomGenerator::GetRandomUInt()
 {
-    return uniformUnsignedIntDistribution(randomGenerator);
+    return sampleState.generator.NextUInt();
 }
 
 // Return random unsigned integer in [0, max]
@@ -7,11 +7,95 @@
 #ifndef __RANDOMGENERATOR_H__
 #define __RANDOMGENERATOR_H__
 
+#include <cstdint>
+
+#include "Sampler.h"
+
+/*
+    PCG32 generator (pcg32_xsh_rr, O'Neill 2014)
+    64 bits of state and one fixed stream, so a single integer is enough to save and restore it
+*/
+struct PCG32
+{
+    inline uint32_t NextUInt()
+    {
+        uint64_t oldState = state;
+        state = oldState * PCG32_MULTIPLIER + PCG32_INCREMENT;
+
+        uint32_t xorShifted = (uint32_t)(((oldState >> 18u) ^ oldState) >> 27u);
+        uint32_t rotation = (uint32_t)(oldState >> 59u);
+
+        return (xorShifted >> rotation) | (xorShifted << ((-rotation) & 31));
+    }
+
+    // Uniform float in [0, 1) from the upper 24 bits
+    inline float NextFloat()
+    {
+        return (NextUInt() >> 8) * (1.f / 16777216.f);
+    }
+
+    static constexpr uint64_t PCG32_MULTIPLIER = 6364136223846793005ull;
+    static constexpr uint64_t PCG32_INCREMENT = 1442695040888963407ull;
+
+    uint64_t state = 0x853c49e6748fea9bull;
+};
+
+// Position of a thread in its pixel sample
+struct SampleState
+{
+    PCG32 generator;
+
+    uint32_t pixelSeed;
+    uint32_t sampleIndex;
+
+    // Next path dimension of the sampler
+    uint32_t dimension;
+};
+
 class RandomGenerator
 {
 public:
-    // Return random float in [0, 1]
-    static float GetRandomFloat();
+    // Sets the sampler GetRandomFloat and GetSample draw from, independent sampling uses the thread's generator
+    static void SetSampler(SAMPLER_TYPE type);
+
+    // Restarts the calling thread's generator at the sequence of the pixel sample
+    // The sequence only depends on its arguments, so images do not depend on which thread renders what
+    // The position in the sequence is the sample dimension
+    static void StartSample(uint32_t pixelIndex, uint32_t sampleIndex, uint32_t frameIndex = 0);
+
+    // Saves and restores the calling thread's sample, used to carry a path's sequence between threads
+    static inline const SampleState &GetState()
+    {
+        return sampleState;
+    }
+
+    static inline void SetState(const SampleState &state)
+    {
+        sampleState = state;
+    }
+
+    // Return random float in [0, 1], the next path dimension of the sample
+    static inline float GetRandomFloat()
+    {
+        if(sampler)
+        {
+            return sampler->GetSample(sampleState.pixelSeed, sampleState.sampleIndex, sampleState.dimension++);
+        }
+
+        return sampleState.generator.NextFloat();
+    }
+
+    // Return the sample's value of a camera dimension in [0, 1]
+    // Independent sampling has no dimensions and returns the next random float
+    static inline float GetSample(uint32_t dimension)
+    {
+        if(sampler)
+        {
+            return sampler->GetSample(sampleState.pixelSeed, sampleState.sampleIndex, dimension);
+        }
+
+        return sampleState.generator.NextFloat();
+    }
 
     // Return Gaussian random float in [0, 1]
     static float GetGaussianRandomFloat();
@@ -48,7 +132,10 @@ public:
 
 //    static bool UnitTest();
 private:
+    static const Sampler *sampler;
 
+    // Every thread draws from its own generator
+    static thread_local SampleState sampleState;
 };
 
 #endif
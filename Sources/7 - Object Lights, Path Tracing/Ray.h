@@ -9,6 +9,7 @@
 
 #include "Math.h"
 #include "RandomGenerator.h"
+#include "SIMD.h"
 
 class ObjectBase;
 
@@ -17,13 +18,20 @@ class Ray
 public:
     Ray() : e(Vector3::ZeroVector), dir(Vector3::ZeroVector), insideOf(nullptr)
     {
-        
+        Precompute();
     }
 
     Ray(const Vector3 &eye, const Vector3 & d, ObjectBase *inside = nullptr) : 
         e(eye), dir(d), insideOf(inside)
     {
+        Precompute();
+    }
 
+    // Ray that only reports the hits in (minT, maxT)
+    Ray(const Vector3 &eye, const Vector3 & d, float minT, float maxT) : 
+        e(eye), dir(d), tMin(minT), tMax(maxT), insideOf(nullptr)
+    {
+        Precompute();
     }
     
     ~Ray()
@@ -51,6 +59,75 @@ public:
 
     // Returns a direction with an angle between 0 and 90 with respect to reference ray
     static inline Vector3 GetRandomHemiSphericalDirection(const Vector3 &referenceRay)
+    {
+        float randomValue1 = RandomGenerator::GetRandomFloat(); 
+        float randomValue2 = RandomGenerator::GetRandomFloat();
+    
+        float sinTheta = sqrtf(1 - randomValue1 * randomValue1); 
+        float phi = 2 * M_PI * randomValue2; 
+        float x = sinTheta * cosf(phi);
+        float z = sinTheta * sinf(phi);
+        Vector3 sample = Vector3(x, randomValue1, z); 
+        
+        return GetHemisphereDirection(sample, referenceRay);
+    }
+
+    // Returns a direction distributed with the cosine of its angle to the reference ray, the density is cos / PI
+    // Malley's method, a uniform point on the unit disk is projected up to the hemisphere
+    static inline Vector3 GetCosineWeightedHemiSphericalDirection(const Vector3 &referenceRay)
+    {
+        // Concentric mapping of the unit square to the disk keeps the samples' strata
+        float offsetX = 2.f * RandomGenerator::GetRandomFloat() - 1.f;
+        float offsetY = 2.f * RandomGenerator::GetRandomFloat() - 1.f;
+
+        float radius = 0.f;
+        float phi = 0.f;
+
+        if(std::fabs(offsetX) > std::fabs(offsetY))
+        {
+            radius = offsetX;
+            phi = (PI * 0.25f) * (offsetY / offsetX);
+        }
+        else if(offsetY != 0.f)
+        {
+            radius = offsetY;
+            phi = HALF_PI - (PI * 0.25f) * (offsetX / offsetY);
+        }
+
+        float x = radius * cosf(phi);
+        float z = radius * sinf(phi);
+        Vector3 sample = Vector3(x, sqrtf(mathMax(0.f, 1.f - x * x - z * z)), z);
+
+        return GetHemisphereDirection(sample, referenceRay);
+    }
+
+    // Returns the direction at the polar angle with the cosine cosTheta and the azimuth phi around the reference ray
+    static inline Vector3 GetDirectionAround(const Vector3 &referenceRay, float cosTheta, float phi)
+    {
+        float sinTheta = sqrtf(mathMax(0.f, 1.f - cosTheta * cosTheta));
+        Vector3 sample = Vector3(sinTheta * cosf(phi), cosTheta, sinTheta * sinf(phi));
+
+        return GetHemisphereDirection(sample, referenceRay);
+    }
+
+    // Can they be constant references?
+    Vector3 e;
+    Vector3 dir;
+
+    // Box slab distances are (bound - e) * invDir, an axis parallel direction gives infinite slabs instead of NaNs
+    Vector3 invDir;
+
+    // 1 where the direction component is negative, indexes the near and far box bounds
+    int sign[3];
+
+    // Hits are valid in (tMin, tMax), traversal passes a copy with a smaller tMax on once a closer hit is found
+    float tMin = 0.f;
+    float tMax = MAX_FLOAT;
+
+    ObjectBase *insideOf;
+private:
+    // Maps the sample from the frame whose y axis is the reference ray to world space
+    static inline Vector3 GetHemisphereDirection(const Vector3 &sample, const Vector3 &referenceRay)
     {
         // Create coordinate system
         Vector3 u, v;
@@ -64,27 +141,77 @@ public:
         }
         v = Vector3::Cross(referenceRay, u); 
 
-        float randomValue1 = RandomGenerator::GetRandomFloat(); 
-        float randomValue2 = RandomGenerator::GetRandomFloat();
-    
-        float sinTheta = sqrtf(1 - randomValue1 * randomValue1); 
-        float phi = 2 * M_PI * randomValue2; 
-        float x = sinTheta * cosf(phi);
-        float z = sinTheta * sinf(phi);
-        Vector3 sample = Vector3(x, randomValue1, z); 
-        
         return Vector3( sample.x * u.x + sample.y * referenceRay.x + sample.z * v.x, 
                         sample.x * u.y + sample.y * referenceRay.y + sample.z * v.y, 
                         sample.x * u.z + sample.y * referenceRay.z + sample.z * v.z);
     }
 
-    // Can they be constant references?
-    Vector3 e;
-    Vector3 dir;
+    inline void Precompute()
+    {
+        invDir = Vector3(1.f / dir.x, 1.f / dir.y, 1.f / dir.z);
 
-    ObjectBase *insideOf;
-private:
+        sign[0] = invDir.x < 0;
+        sign[1] = invDir.y < 0;
+        sign[2] = invDir.z < 0;
+    }
 
 };
 
+/*
+    Packet of Float::Width rays stored as one packet per component
+    Lanes are computed with the same operations as Ray, so a lane gives the same result as the ray it was packed from
+*/
+template <typename Float>
+class RayPacketN
+{
+public:
+    typedef typename Float::Mask Mask;
+
+    static const int Width = Float::Width;
+
+    RayPacketN(const Vector3xN<Float> &eye, const Vector3xN<Float> &d, const Float &minT, const Float &maxT) :
+        e(eye), dir(d), invDir(Float(1.f) / d.x, Float(1.f) / d.y, Float(1.f) / d.z), tMin(minT), tMax(maxT)
+    {
+
+    }
+
+    // Packs the first count rays, the remaining lanes repeat the first ray
+    static inline RayPacketN Load(const Ray *rays, int count)
+    {
+        float ex[Width], ey[Width], ez[Width];
+        float dx[Width], dy[Width], dz[Width];
+        float minTs[Width], maxTs[Width];
+
+        for(int lane = 0; lane < Width; lane++)
+        {
+            const Ray &ray = rays[lane < count ? lane : 0];
+
+            ex[lane] = ray.e.x;
+            ey[lane] = ray.e.y;
+            ez[lane] = ray.e.z;
+            dx[lane] = ray.dir.x;
+            dy[lane] = ray.dir.y;
+            dz[lane] = ray.dir.z;
+            minTs[lane] = ray.tMin;
+            maxTs[lane] = ray.tMax;
+        }
+
+        return RayPacketN(Vector3xN<Float>::Load(ex, ey, ez), Vector3xN<Float>::Load(dx, dy, dz), Float::Load(minTs), Float::Load(maxTs));
+    }
+
+    inline Ray GetLane(int index) const
+    {
+        return Ray(e.GetLane(index), dir.GetLane(index), tMin[index], tMax[index]);
+    }
+
+    Vector3xN<Float> e;
+    Vector3xN<Float> dir;
+    Vector3xN<Float> invDir;
+
+    Float tMin;
+    Float tMax;
+};
+
+typedef RayPacketN<Float8> RayPacket8;
+
 #endif
\ No newline at end of file
@@ -4,12 +4,15 @@
  *	2018
  */
 
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <chrono>
 
 #include "Scene.h"
 #include "Renderer.h"
+#include "ThreadPool.h"
+#include "Topology.h"
 
 #include "IOManager.h"
 
@@ -28,15 +31,69 @@ int main(int argc, char** argv)
 
     std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
 
+    // Thread count priority is --threads, then the environment, then the scene and then the hardware
+    unsigned int threadCount = ThreadPool::ParseThreadCount(getenv(THREAD_COUNT_ENVIRONMENT_VARIABLE));
+
+    // Placement is set before the pool starts, so the scene data is allocated under the memory policy
+    bool pinThreads = false;
+    MEMORY_POLICY memoryPolicy = MEMORY_POLICY::LOCAL;
+
+    for(int argIndex = 1; argIndex < argc; argIndex++)
+    {
+        if(strcmp(argv[argIndex], "--threads") == 0 && argIndex + 1 < argc)
+        {
+            threadCount = ThreadPool::ParseThreadCount(argv[argIndex + 1]);
+
+            if(threadCount == 0)
+            {
+                std::cerr << "Invalid thread count: " << argv[argIndex + 1] << std::endl;
+                return -1;
+            }
+        }
+        else if(strcmp(argv[argIndex], "--pinThreads") == 0)
+        {
+            pinThreads = true;
+        }
+        else if(strcmp(argv[argIndex], "--memoryPolicy") == 0 && argIndex + 1 < argc)
+        {
+            if(!Topology::ParseMemoryPolicy(argv[argIndex + 1], memoryPolicy))
+            {
+                std::cerr << "Invalid memory policy: " << argv[argIndex + 1] << std::endl;
+                return -1;
+            }
+        }
+    }
+
+    Topology::Detect();
+    Topology::SetPlacement(pinThreads, memoryPolicy);
+
+    ThreadPool::Initialize(threadCount);
+
     Scene mainScene;
     mainScene.ReadSceneData(argv[1]);
 
+    if(threadCount == 0 && mainScene.threadCount > 0)
+    {
+        ThreadPool::Initialize(mainScene.threadCount);
+    }
+
+    std::cout << "Rendering with " << ThreadPool::GetThreadCount() << " threads." << std::endl;
+    Topology::PrintReport(ThreadPool::GetThreadCount());
+
     for(unsigned char argIndex = 1; argIndex < argc; argIndex++)
     {
         if(strcmp(argv[argIndex], "--noBVH") == 0)
         {
             mainScene.useBVH = false;
         }
+        else if(strcmp(argv[argIndex], "--sortRays") == 0)
+        {
+            mainScene.sortSecondaryRays = true;
+        }
+        else if(strcmp(argv[argIndex], "--progress") == 0 && argIndex + 1 < argc)
+        {
+            mainScene.progressInterval = atof(argv[argIndex + 1]);
+        }
     }
 
     std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
@@ -44,6 +101,7 @@ int main(int argc, char** argv)
     std::cout << "Time elapsed to read the scene data: " << elapsedTimeToReadTheScene / pow(10, 6) << " seconds / " << elapsedTimeToReadTheScene << " microseconds." << std::endl;
 
     if(mainScene.useBVH) mainScene.CreateBVH();
+    if(mainScene.useLightBVH) mainScene.lightBVH.Build(mainScene.lights);
     
     std::chrono::high_resolution_clock::time_point t3 = std::chrono::high_resolution_clock::now();
     auto elapsedTimeToCreateBVH = std::chrono::duration_cast<std::chrono::microseconds>( t3 - t2 ).count();
@@ -75,6 +133,8 @@ int main(int argc, char** argv)
     std::chrono::high_resolution_clock::time_point t4 = std::chrono::high_resolution_clock::now();
     auto elapsedTimeToRender = std::chrono::duration_cast<std::chrono::microseconds>( t4 - t3 ).count();
     std::cout << "Time elapsed to render the scene: " << elapsedTimeToRender / pow(10, 6) << " seconds / " << elapsedTimeToRender << " microseconds." << std::endl;
+
+    ThreadPool::Shutdown();
  
     return 0;
 }
\ No newline at end of file
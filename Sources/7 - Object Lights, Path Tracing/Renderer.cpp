@@ -7,197 +7,478 @@
 #include "Renderer.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
-#include <mutex>
-#include <thread>
+#include <sstream>
 
 #include "BRDF.h"
 #include "DirectionalLight.h"
 #include "Scene.h"
+#include "ImageWriter.h"
 #include "IOManager.h"
 #include "LightMesh.h"
 #include "LightSphere.h"
 #include "Material.h"
 #include "Mesh.h"
 #include "ObjectBase.h"
+#include "ProgressReporter.h"
 #include "RandomGenerator.h"
+#include "ShadowRayStream.h"
 #include "Texture.h"
-
-std::mutex mutex;
-
-#define MAX_THREAD_COUNT 8
+#include "ThreadPool.h"
+#include "TileScheduler.h"
+#include "WavefrontRenderer.h"
 
 #define GAUSSIAN_VALUE(x, y) ((1 / TWO_PI) * (pow(NATURAL_LOGARITHM, -((x * x + y * y) * 0.5f))))
 #define SCHLICKS_APPROXIMATION(cosTetha, R0) (R0 + (1 - R0) * pow(1 - cosTetha, 5))
 
-int imageWidth, imageHeight;
+// Pixels per tone mapping chunk
+#define TONE_MAPPING_GRAIN_SIZE 4096
+
+// Samples taken between two convergence tests of an adaptive pixel
+#define ADAPTIVE_SAMPLE_BATCH_SIZE 4
+
+// Keeps the relative error of dark pixels finite
+#define ADAPTIVE_LUMINANCE_FLOOR 1e-3f
+
+// Blue to red ramp of the sample count heatmap, t in [0, 1]
+static inline Colorf GetHeatmapColor(float t)
+{
+    t = mathClamp(t, 0.f, 1.f) * 4.f;
+
+    if(t < 1.f) return Colorf(0.f, t, 1.f) * 255.f;
+    if(t < 2.f) return Colorf(0.f, 1.f, 2.f - t) * 255.f;
+    if(t < 3.f) return Colorf(t - 2.f, 1.f, 0.f) * 255.f;
+    return Colorf(1.f, 4.f - t, 0.f) * 255.f;
+}
+
+// Reflectance of the lobes the material's BRDF or its diffuse term samples, the specular lobe only counts with a BRDF
+static inline float GetSurfaceWeight(const Material *material, const Vector3 &diffuseColor)
+{
+    if(material->brdf)
+    {
+        return diffuseColor.GetMaxComponent() + material->specular.GetMaxComponent();
+    }
+
+    return diffuseColor.GetMaxComponent();
+}
+
+// Side of the light's grid of shadow sample strata
+static inline unsigned int GetLightStrataCount(const Light *light)
+{
+    return mathMax(1u, (unsigned int)sqrt((float)light->sampleCount));
+}
+
+// Shadow samples taken of the light at every shading point
+static inline unsigned int GetLightSampleCount(const Light *light)
+{
+    unsigned int strataCount = GetLightStrataCount(light);
+    return strataCount * strataCount;
+}
 
-unsigned int renderedPixelAmount = 0;
-unsigned int totalPixelAmount = 0;
+// Shadow rays of the shading calls running on the thread
+thread_local ShadowRayStream shadowRayStream;
 
 void Renderer::RenderScene()
 {
     int cameraCount = mainScene->cameras.size();
 
+    uint64_t totalPixelAmount = 0;
+
     for(int cameraIndex = 0; cameraIndex < cameraCount; cameraIndex++)
     {
         Camera *currentCamera = &mainScene->cameras[cameraIndex];
-        totalPixelAmount += currentCamera->imageHeight * currentCamera->imageWidth;
+        totalPixelAmount += (uint64_t)currentCamera->imageHeight * currentCamera->imageWidth;
     }
 
+    RandomGenerator::SetSampler(mainScene->samplerType);
+
+    ProgressReporter::Start(totalPixelAmount, mainScene->progressInterval);
+    ImageWriter::Start();
+
+    // Cameras are jobs sharing the pool, the queue hands out their tasks in camera order
+    // so a camera's tone mapping and output overlap the tracing of the next ones
+    TaskGroup cameraTasks;
+
     for(int cameraIndex = 0; cameraIndex < cameraCount; cameraIndex++)
     {
         Camera *currentCamera = &mainScene->cameras[cameraIndex];
 
-        imageWidth = currentCamera->imageWidth;
-        imageHeight = currentCamera->imageHeight;
+        cameraTasks.Run([currentCamera]
+        {
+            RenderCamera(currentCamera);
+        });
+    }
 
-        unsigned int imageSize = imageWidth * imageHeight;
-        unsigned int colorSize = imageSize * 3;
-        //unsigned char *image = new unsigned char[colorSize];
-        float *image = new float[colorSize];
-        
-        std::thread threads[MAX_THREAD_COUNT + 1];
+    cameraTasks.Wait();
+
+    ImageWriter::Finish();
+    ProgressReporter::Stop();
+}
+
+void Renderer::RenderCamera(Camera *currentCamera)
+{
+    int imageWidth = currentCamera->imageWidth;
+    int imageHeight = currentCamera->imageHeight;
+
+    unsigned int imageSize = imageWidth * imageHeight;
+    unsigned int colorSize = imageSize * 3;
+    //unsigned char *image = new unsigned char[colorSize];
+    float *image = new float[colorSize];
+    float *heatmapImage = nullptr;
+    
+    if(mainScene->integrator == INTEGRATOR::WAVEFRONT_PATH_TRACER)
+    {
+        WavefrontRenderer::RenderImage(currentCamera, imageWidth, imageHeight, image);
+    }
+    else if(currentCamera->progressive)
+    {
+        RenderProgressive(currentCamera, image);
+    }
+    else
+    {
+        std::vector<unsigned int> sampleCounts(currentCamera->adaptiveSampling ? imageSize : 0);
+        Filter filter(currentCamera->filterType, currentCamera->filterRadius, currentCamera->filterMode);
 
-        int startingX = 0, startingY = 0;
+        TileScheduler tileScheduler(imageWidth, imageHeight, mainScene->tileSize, mainScene->tileOrder, ThreadPool::GetThreadCount());
+        std::vector<std::vector<float>> splatBuffers;
 
-        int threadedHeight = imageHeight / MAX_THREAD_COUNT;
-        int residualHeight = imageHeight - (threadedHeight * MAX_THREAD_COUNT);
+        RenderTarget target;
+        target.colorBuffer = image;
 
-        for(unsigned int i = 0; i < MAX_THREAD_COUNT; i++)
+        // Adaptive pixels average their samples, so they take no filter
+        if(currentCamera->adaptiveSampling)
         {
-            threads[i] = std::thread(&Renderer::ThreadFunction, currentCamera, startingX, startingY, imageWidth, threadedHeight, image);
-            startingY += threadedHeight;
+            target.sampleCountBuffer = sampleCounts.data();
         }
-        
-        threads[MAX_THREAD_COUNT] = std::thread(&Renderer::ThreadFunction, currentCamera, startingX, startingY, imageWidth, residualHeight, image);
-        
-        // Wait all the threads to join including residual thread
-        for(unsigned int i = 0; i <= MAX_THREAD_COUNT; i++)
+        else if(currentCamera->useFilter)
         {
-            threads[i].join();
+            target.filter = &filter;
+
+            if(filter.GetMode() == FILTER_MODE::SPLAT)
+            {
+                splatBuffers.resize(tileScheduler.GetTileCount());
+                target.splatBuffers = &splatBuffers;
+            }
         }
 
-        // SRGB Gamma Correction
-        // if(currentCamera->gammaCorrection == GAMMA_CORRECTION::SRGB)
-        // {          
-        //     float maxColorValue = 255.f;
-  
-        //     for(size_t colorIndex = 0; colorIndex < colorSize; colorIndex++)
-        //     {
-        //         if(image[colorIndex] > maxColorValue)
-        //         {
-        //             maxColorValue = image[colorIndex];
-        //         }
-        //     }
-
-        //     float oneOver2Point4 = 1 / 2.4f;
-
-        //     for(size_t colorIndex = 0; colorIndex < colorSize; colorIndex++)
-        //     {
-        //         float normalizedValue = image[colorIndex] / maxColorValue;
-        //         if(normalizedValue <= 0.031308f)
-        //         {
-        //             normalizedValue *= 12.92f;
-        //         }
-        //         else
-        //         {
-        //             normalizedValue = 1.055f * pow(normalizedValue, oneOver2Point4) - 0.055f;
-        //         }
-
-        //         image[colorIndex] = normalizedValue * maxColorValue;
-        //     }
-        // }
-
-        if(currentCamera->TMO != TONE_MAPPING_TYPE::NONE)
-        {
-            float whiteLuminance = 0.f;
-            double totalLogLuminance = 0.f;
-
-            std::vector<float> luminanceValues;
-
-            for(unsigned int colorIndex = 0; colorIndex < colorSize; colorIndex += 3)
+        ThreadPool::Run([&](unsigned int threadIndex)
+        {
+            ThreadFunction(currentCamera, &tileScheduler, threadIndex, target);
+        });
+
+        if(target.splatBuffers)
+        {
+            ResolveSplatBuffers(currentCamera, tileScheduler, target);
+        }
+
+        if(currentCamera->adaptiveSampling)
+        {
+            uint64_t totalSampleCount = 0;
+            unsigned int maxSampleCount = mathMax(currentCamera->numberOfSamples, 1u);
+
+            heatmapImage = new float[colorSize];
+
+            for(unsigned int pixelIndex = 0; pixelIndex < imageSize; pixelIndex++)
             {
-                float luminance = 0.27f * image[colorIndex] + 0.67f * image[colorIndex + 1] + 0.06f * image[colorIndex + 2];
-                //float luminance = 0.2126f * image[colorIndex] + 0.7152f * image[colorIndex + 1] + 0.0722f * image[colorIndex + 2];
+                totalSampleCount += sampleCounts[pixelIndex];
 
-                luminanceValues.push_back(luminance);
-                totalLogLuminance += log(luminance + EPSILON);
+                Colorf heatmapColor = GetHeatmapColor((float)sampleCounts[pixelIndex] / maxSampleCount);
+                heatmapImage[3 * pixelIndex    ] = heatmapColor.r;
+                heatmapImage[3 * pixelIndex + 1] = heatmapColor.g;
+                heatmapImage[3 * pixelIndex + 2] = heatmapColor.b;
             }
 
-            std::make_heap(luminanceValues.begin(), luminanceValues.end());
-            std::sort_heap(luminanceValues.begin(), luminanceValues.end());
+            std::ostringstream report;
+            report << currentCamera->imageName << ": " << (double)totalSampleCount / imageSize << " samples per pixel on average, "
+                   << maxSampleCount << " at most.\n";
 
-            float whiteLuminanceIndex = (100.f - currentCamera->TMOOptions.y) / 100.f;
-            whiteLuminance = luminanceValues[round(luminanceValues.size() * whiteLuminanceIndex)];// / luminanceValues[luminanceValues.size() - 1];
+            std::cout << report.str() << std::flush;
+        }
+    }
 
-            totalLogLuminance /= imageSize;
-            float logAverageLuminance = exp(totalLogLuminance);
-            
-            float *toneMappingImage = new float[colorSize];
+    // SRGB Gamma Correction
+    // if(currentCamera->gammaCorrection == GAMMA_CORRECTION::SRGB)
+    // {          
+    //     float maxColorValue = 255.f;
+  
+    //     for(size_t colorIndex = 0; colorIndex < colorSize; colorIndex++)
+    //     {
+    //         if(image[colorIndex] > maxColorValue)
+    //         {
+    //             maxColorValue = image[colorIndex];
+    //         }
+    //     }
+
+    //     float oneOver2Point4 = 1 / 2.4f;
+
+    //     for(size_t colorIndex = 0; colorIndex < colorSize; colorIndex++)
+    //     {
+    //         float normalizedValue = image[colorIndex] / maxColorValue;
+    //         if(normalizedValue <= 0.031308f)
+    //         {
+    //             normalizedValue *= 12.92f;
+    //         }
+    //         else
+    //         {
+    //             normalizedValue = 1.055f * pow(normalizedValue, oneOver2Point4) - 0.055f;
+    //         }
+
+    //         image[colorIndex] = normalizedValue * maxColorValue;
+    //     }
+    // }
+
+    float *toneMappingImage = ToneMapImage(currentCamera, image);
+
+    ImageWriter::Enqueue(currentCamera, imageWidth, imageHeight, image, toneMappingImage, heatmapImage);
+}
+
+void Renderer::RenderProgressive(Camera *currentCamera, float *image)
+{
+    const RendererInfo ri(currentCamera, currentCamera - mainScene->cameras.data());
+
+    unsigned int imageSize = currentCamera->imageWidth * currentCamera->imageHeight;
+    unsigned int colorSize = imageSize * 3;
+    unsigned int targetSampleCount = mathMax(currentCamera->numberOfSamples, 1u);
 
-            for(unsigned int colorIndex = 0; colorIndex < colorSize; colorIndex += 3)
+    // Sums of the samples, every pass adds to it
+    std::vector<float> accumulationBuffer(colorSize, 0.f);
+
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point lastOutputTime = startTime;
+
+    unsigned int sampleCount = 0;
+    unsigned int passSampleCount = 1;
+    uint64_t reportedPixelCount = 0;
+
+    while(passSampleCount > 0)
+    {
+        std::chrono::steady_clock::time_point passStartTime = std::chrono::steady_clock::now();
+
+        TileScheduler tileScheduler(currentCamera->imageWidth, currentCamera->imageHeight, mainScene->tileSize, mainScene->tileOrder, ThreadPool::GetThreadCount());
+
+        ThreadPool::Run([&](unsigned int threadIndex)
+        {
+            Tile tile;
+
+            while(tileScheduler.GetNextTile(threadIndex, tile))
             {
-                float luminance = 0.27f * image[colorIndex] + 0.67f * image[colorIndex + 1] + 0.06f * image[colorIndex + 2];
-                //float luminance = 0.2126f * image[colorIndex] + 0.7152f * image[colorIndex + 1] + 0.0722f * image[colorIndex + 2];
-
-                float scaledLuminance = luminance * currentCamera->TMOOptions.x / logAverageLuminance;
-                //float displayLuminance = scaledLuminance / (1 + scaledLuminance);
-                float displayLuminance = (scaledLuminance * (1 + (scaledLuminance / (whiteLuminance * whiteLuminance)))) / (1 + scaledLuminance);
-                float finalLuminance = displayLuminance;
-
-                float displayR = mathClamp(pow(image[colorIndex] / luminance, currentCamera->saturation) * finalLuminance, 0, 1);
-                float displayG = mathClamp(pow(image[colorIndex + 1] / luminance, currentCamera->saturation) * finalLuminance, 0, 1);
-                float displayB = mathClamp(pow(image[colorIndex + 2] / luminance, currentCamera->saturation) * finalLuminance, 0, 1);
-                
-                toneMappingImage[colorIndex    ] = pow(displayR, 0.45f) * 255;
-                toneMappingImage[colorIndex + 1] = pow(displayG, 0.45f) * 255;
-                toneMappingImage[colorIndex + 2] = pow(displayB, 0.45f) * 255;
+                RenderProgressiveTile(currentCamera, ri, tile, accumulationBuffer.data(), sampleCount, passSampleCount);
             }
-            
-            std::string pngImageName = currentCamera->imageName.substr(0, currentCamera->imageName.length() - 4);
-            pngImageName += ".png";
+        });
+
+        sampleCount += passSampleCount;
+
+        // Pixels count as done in proportion to the samples taken
+        uint64_t donePixelCount = (uint64_t)imageSize * sampleCount / targetSampleCount;
+        ProgressReporter::AddPixels(donePixelCount - reportedPixelCount);
+        reportedPixelCount = donePixelCount;
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        float elapsedSeconds = std::chrono::duration<float>(now - startTime).count();
+        float secondsPerSample = std::chrono::duration<float>(now - passStartTime).count() / passSampleCount;
+
+        // Every pass doubles the samples taken so far, as long as the target and the budget allow
+        passSampleCount = mathMin(sampleCount, targetSampleCount - sampleCount);
+
+        if(currentCamera->timeBudget > 0.f)
+        {
+            float remainingSeconds = currentCamera->timeBudget - elapsedSeconds;
+            unsigned int affordableSampleCount = remainingSeconds > 0.f ? (unsigned int)(remainingSeconds / mathMax(secondsPerSample, EPSILON)) : 0;
 
-            IOManager::WritePng(pngImageName.c_str(), imageWidth, imageHeight, toneMappingImage);
+            passSampleCount = mathMin(passSampleCount, affordableSampleCount);
         }
 
-        std::string extension;
-        unsigned int imageNameLength = currentCamera->imageName.length();
-        
-        for(int nameIndex = imageNameLength - 1; nameIndex >= 0; nameIndex--)
+        if(passSampleCount > 0 && currentCamera->outputInterval > 0.f && std::chrono::duration<float>(now - lastOutputTime).count() >= currentCamera->outputInterval)
         {
-            if(currentCamera->imageName.c_str()[nameIndex] != '.')
+            float *intermediateImage = new float[colorSize];
+
+            for(unsigned int colorIndex = 0; colorIndex < colorSize; colorIndex++)
             {
-                extension.insert(0, 1, currentCamera->imageName.c_str()[nameIndex]);
+                intermediateImage[colorIndex] = accumulationBuffer[colorIndex] / sampleCount;
             }
-            else
+
+            ImageWriter::Enqueue(currentCamera, currentCamera->imageWidth, currentCamera->imageHeight, intermediateImage, ToneMapImage(currentCamera, intermediateImage));
+            lastOutputTime = now;
+        }
+    }
+
+    ProgressReporter::AddPixels(imageSize - reportedPixelCount);
+
+    for(unsigned int colorIndex = 0; colorIndex < colorSize; colorIndex++)
+    {
+        image[colorIndex] = accumulationBuffer[colorIndex] / sampleCount;
+    }
+
+    std::ostringstream report;
+    report << currentCamera->imageName << ": " << sampleCount << " samples per pixel in "
+           << std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count() << " seconds.\n";
+
+    std::cout << report.str() << std::flush;
+}
+
+void Renderer::RenderProgressiveTile(Camera *currentCamera, const RendererInfo &ri, const Tile &tile, float *accumulationBuffer, unsigned int firstSample, unsigned int sampleCount)
+{
+    unsigned int imageWidth = currentCamera->imageWidth;
+    unsigned int endX = tile.startX + tile.width;
+    unsigned int endY = tile.startY + tile.height;
+
+    for(unsigned int y = tile.startY; y < endY; y++)
+    {
+        for(unsigned int x = tile.startX; x < endX; x++)
+        {
+            uint32_t imagePixelIndex = y * imageWidth + x;
+            Colorf pixelColor(0.f, 0.f, 0.f);
+
+            for(unsigned int sampleIndex = firstSample; sampleIndex < firstSample + sampleCount; sampleIndex++)
             {
-                break;
+                RandomGenerator::StartSample(imagePixelIndex, sampleIndex, ri.frameIndex);
+
+                float randomU = RandomGenerator::GetSample(SAMPLE_PIXEL_DIMENSION);
+                float randomV = RandomGenerator::GetSample(SAMPLE_PIXEL_DIMENSION + 1);
+
+                pixelColor += RenderPixel(x + randomU, y + randomV, ri);
             }
-        }
 
-        if(extension == "png") IOManager::WritePng(currentCamera->imageName.c_str(), imageWidth, imageHeight, image);
-        else if(extension == "exr") IOManager::WriteExr(currentCamera->imageName.c_str(), imageWidth, imageHeight, image);
-        else if(extension == "ppm") true;//IOManager::WritePpm(currentCamera->imageName.c_str(), imageWidth, imageHeight, image);
-        else std::cerr << "Output extension is unknown! Extension is: " << extension << std::endl; 
+            // Tiles never share pixels, so the sums are added without synchronization
+            accumulationBuffer[3 * imagePixelIndex    ] += pixelColor.r;
+            accumulationBuffer[3 * imagePixelIndex + 1] += pixelColor.g;
+            accumulationBuffer[3 * imagePixelIndex + 2] += pixelColor.b;
+        }
     }
 }
 
-void Renderer::ThreadFunction(Camera *currentCamera, int startX, int startY, int width, int height, float *colorBuffer)
+float *Renderer::ToneMapImage(const Camera *currentCamera, const float *image)
 {
-    if(height == 0) return;
+    if(currentCamera->TMO == TONE_MAPPING_TYPE::NONE)
+    {
+        return nullptr;
+    }
+
+    unsigned int imageSize = currentCamera->imageWidth * currentCamera->imageHeight;
+    unsigned int colorSize = imageSize * 3;
+
+    float whiteLuminance = 0.f;
+    double totalLogLuminance = 0.f;
+
+    std::vector<float> luminanceValues(imageSize);
+
+    // Log luminances are summed per chunk and then in chunk order, so the sum does not depend on the thread count
+    std::vector<double> chunkLogLuminances((imageSize + TONE_MAPPING_GRAIN_SIZE - 1) / TONE_MAPPING_GRAIN_SIZE, 0.0);
 
-    const RendererInfo ri(currentCamera);
+    ThreadPool::ParallelFor(imageSize, TONE_MAPPING_GRAIN_SIZE, [&](size_t begin, size_t end)
+    {
+        double chunkLogLuminance = 0.0;
+
+        for(size_t pixelIndex = begin; pixelIndex < end; pixelIndex++)
+        {
+            size_t colorIndex = pixelIndex * 3;
+
+            float luminance = 0.27f * image[colorIndex] + 0.67f * image[colorIndex + 1] + 0.06f * image[colorIndex + 2];
+            //float luminance = 0.2126f * image[colorIndex] + 0.7152f * image[colorIndex + 1] + 0.0722f * image[colorIndex + 2];
+
+            luminanceValues[pixelIndex] = luminance;
+            chunkLogLuminance += log(luminance + EPSILON);
+        }
+
+        chunkLogLuminances[begin / TONE_MAPPING_GRAIN_SIZE] = chunkLogLuminance;
+    });
+
+    for(double chunkLogLuminance : chunkLogLuminances)
+    {
+        totalLogLuminance += chunkLogLuminance;
+    }
+
+    // Only the luminance at the white point's rank is needed, a selection is enough instead of a full sort
+    float whiteLuminanceIndex = (100.f - currentCamera->TMOOptions.y) / 100.f;
+    size_t whiteLuminanceRank = mathMin((size_t)round(luminanceValues.size() * whiteLuminanceIndex), luminanceValues.size() - 1);
+
+    std::nth_element(luminanceValues.begin(), luminanceValues.begin() + whiteLuminanceRank, luminanceValues.end());
+    whiteLuminance = luminanceValues[whiteLuminanceRank];// / luminanceValues[luminanceValues.size() - 1];
+
+    totalLogLuminance /= imageSize;
+    float logAverageLuminance = exp(totalLogLuminance);
     
-    int pixelIndex = 3 * (startY * width + startX);
+    float *toneMappingImage = new float[colorSize];
+
+    ThreadPool::ParallelFor(imageSize, TONE_MAPPING_GRAIN_SIZE, [&](size_t begin, size_t end)
+    {
+        for(size_t colorIndex = begin * 3; colorIndex < end * 3; colorIndex += 3)
+        {
+            float luminance = 0.27f * image[colorIndex] + 0.67f * image[colorIndex + 1] + 0.06f * image[colorIndex + 2];
+            //float luminance = 0.2126f * image[colorIndex] + 0.7152f * image[colorIndex + 1] + 0.0722f * image[colorIndex + 2];
+
+            float scaledLuminance = luminance * currentCamera->TMOOptions.x / logAverageLuminance;
+            //float displayLuminance = scaledLuminance / (1 + scaledLuminance);
+            float displayLuminance = (scaledLuminance * (1 + (scaledLuminance / (whiteLuminance * whiteLuminance)))) / (1 + scaledLuminance);
+            float finalLuminance = displayLuminance;
+
+            float displayR = mathClamp(pow(image[colorIndex] / luminance, currentCamera->saturation) * finalLuminance, 0, 1);
+            float displayG = mathClamp(pow(image[colorIndex + 1] / luminance, currentCamera->saturation) * finalLuminance, 0, 1);
+            float displayB = mathClamp(pow(image[colorIndex + 2] / luminance, currentCamera->saturation) * finalLuminance, 0, 1);
+            
+            toneMappingImage[colorIndex    ] = pow(displayR, 0.45f) * 255;
+            toneMappingImage[colorIndex + 1] = pow(displayG, 0.45f) * 255;
+            toneMappingImage[colorIndex + 2] = pow(displayB, 0.45f) * 255;
+        }
+    });
+
+    return toneMappingImage;
+}
+
+void Renderer::ThreadFunction(Camera *currentCamera, TileScheduler *tileScheduler, unsigned int threadIndex, const RenderTarget &target)
+{
+    const RendererInfo ri(currentCamera, currentCamera - mainScene->cameras.data());
+
+    Tile tile;
+
+    while(tileScheduler->GetNextTile(threadIndex, tile))
+    {
+        if(target.splatBuffers)
+        {
+            RenderSplatTile(currentCamera, ri, tile, target);
+        }
+        else
+        {
+            RenderTile(currentCamera, ri, tile, target);
+        }
+
+        ProgressReporter::AddPixels(tile.width * tile.height);
+    }
+}
+
+void Renderer::RenderTile(Camera *currentCamera, const RendererInfo &ri, const Tile &tile, const RenderTarget &target)
+{
+    unsigned int imageWidth = currentCamera->imageWidth;
+    unsigned int endX = tile.startX + tile.width;
+    unsigned int endY = tile.startY + tile.height;
 
-    unsigned int endX = startX + width;
-    unsigned int endY = startY + height;
+    // The tile is accumulated in a buffer first touched by this thread, so it lives on the thread's node
+    // Only the finished rows are copied to the shared image, once per tile
+    static thread_local std::vector<float> tileBuffer;
+    tileBuffer.resize(3 * tile.width * tile.height);
 
-    for(unsigned int y = startY; y < endY; y++)
+    for(unsigned int y = tile.startY; y < endY; y++)
     {
-        for(unsigned int x = startX; x < endX; x++)
+        int pixelIndex = 3 * (y - tile.startY) * tile.width;
+
+        for(unsigned int x = tile.startX; x < endX; x++)
         {
+            uint32_t imagePixelIndex = y * imageWidth + x;
+            uint32_t sampleIndex = 0;
+
+            if(target.sampleCountBuffer || target.filter)
+            {
+                Colorf pixelColor = target.filter ? RenderFilteredPixel(x, y, ri, *target.filter)
+                                                  : RenderAdaptivePixel(x, y, ri, target.sampleCountBuffer[imagePixelIndex]);
+
+                tileBuffer[pixelIndex++] = pixelColor.r;
+                tileBuffer[pixelIndex++] = pixelColor.g;
+                tileBuffer[pixelIndex++] = pixelColor.b;
+                continue;
+            }
+
+            RandomGenerator::StartSample(imagePixelIndex, sampleIndex++, ri.frameIndex);
             Colorf pixelColor = RenderPixel(x + 0.5f, y + 0.5f, ri);
 
             float divider = 1.f;
@@ -210,8 +491,10 @@ void Renderer::ThreadFunction(Camera *currentCamera, int startX, int startY, int
                 {
                     for(int qSample = 0; qSample < qAmount; qSample++)
                     {
-                        float randomU = RandomGenerator::GetRandomFloat();
-                        float randomV = RandomGenerator::GetRandomFloat();
+                        RandomGenerator::StartSample(imagePixelIndex, sampleIndex++, ri.frameIndex);
+
+                        float randomU = RandomGenerator::GetSample(SAMPLE_PIXEL_DIMENSION);
+                        float randomV = RandomGenerator::GetSample(SAMPLE_PIXEL_DIMENSION + 1);
 
                         float gaussianValue = GAUSSIAN_VALUE((pSample + randomU) / pAmount, (qSample + randomV) / qAmount);
 
@@ -222,38 +505,249 @@ void Renderer::ThreadFunction(Camera *currentCamera, int startX, int startY, int
             }
             pixelColor /= divider;
 
-            colorBuffer[pixelIndex++] = pixelColor.r;
-            colorBuffer[pixelIndex++] = pixelColor.g;
-            colorBuffer[pixelIndex++] = pixelColor.b;
-
-            mutex.lock();
-            renderedPixelAmount++;
-            std::cout << (float)renderedPixelAmount * 100 / totalPixelAmount << "% \r";
-            mutex.unlock();
+            tileBuffer[pixelIndex++] = pixelColor.r;
+            tileBuffer[pixelIndex++] = pixelColor.g;
+            tileBuffer[pixelIndex++] = pixelColor.b;
         }
     }
+
+    for(int row = 0; row < tile.height; row++)
+    {
+        memcpy(&target.colorBuffer[3 * ((tile.startY + row) * imageWidth + tile.startX)], &tileBuffer[3 * row * tile.width], 3 * tile.width * sizeof(float));
+    }
 }
 
-Colorf Renderer::RenderPixel(float x, float y, const RendererInfo &ri)
+Ray Renderer::GetPrimaryRay(float x, float y, const RendererInfo &ri)
 {
     Vector3 eye(ri.e);
 
     if(ri.camera->dopEnabled)
     {
-        float randomX = RandomGenerator::GetRandomFloat();
-        float randomY = RandomGenerator::GetRandomFloat();
+        float randomX = RandomGenerator::GetSample(SAMPLE_LENS_DIMENSION);
+        float randomY = RandomGenerator::GetSample(SAMPLE_LENS_DIMENSION + 1);
 
         eye += ri.camera->right * randomX;
         eye += ri.camera->up * randomY;
     }
 
-    float su = (ri.r - ri.l) * x / imageWidth;
-    float sv = (ri.t - ri.b) * y / imageHeight;
+    float su = (ri.r - ri.l) * x / ri.camera->imageWidth;
+    float sv = (ri.t - ri.b) * y / ri.camera->imageHeight;
 
     Vector3 s = ri.q + (ri.u * su) - (ri.v * sv);
     Vector3 d = s - eye;
     d.Normalize();
 
+    return Ray(eye, d);
+}
+
+void Renderer::RenderSplatTile(Camera *currentCamera, const RendererInfo &ri, const Tile &tile, const RenderTarget &target)
+{
+    const Filter &filter = *target.filter;
+
+    unsigned int imageWidth = currentCamera->imageWidth;
+    unsigned int strataCount = mathMax((unsigned int)sqrt(currentCamera->numberOfSamples), 1u);
+
+    // Samples reach the pixels whose centers are closer than the radius, the border holds those outside the tile
+    int border = (int)ceil(filter.GetRadius() + 0.5f);
+    int bufferWidth = tile.width + 2 * border;
+    int bufferHeight = tile.height + 2 * border;
+
+    // Red, green, blue and weight sums, allocated by the rendering thread
+    std::vector<float> &splatBuffer = (*target.splatBuffers)[tile.index];
+    splatBuffer.assign(4 * bufferWidth * bufferHeight, 0.f);
+
+    float radius = filter.GetRadius();
+
+    for(int y = tile.startY; y < tile.startY + tile.height; y++)
+    {
+        for(int x = tile.startX; x < tile.startX + tile.width; x++)
+        {
+            uint32_t imagePixelIndex = y * imageWidth + x;
+
+            for(uint32_t sampleIndex = 0; sampleIndex < strataCount * strataCount; sampleIndex++)
+            {
+                RandomGenerator::StartSample(imagePixelIndex, sampleIndex, ri.frameIndex);
+
+                float u, v;
+                GetPixelSamplePosition(sampleIndex, strataCount, u, v);
+
+                float sampleX = x + u;
+                float sampleY = y + v;
+
+                Colorf sampleColor = RenderPixel(sampleX, sampleY, ri);
+
+                // Pixels whose centers lie within the radius
+                int firstX = mathMax((int)ceil(sampleX - 0.5f - radius), tile.startX - border);
+                int lastX = mathMin((int)floor(sampleX - 0.5f + radius), tile.startX + tile.width + border - 1);
+                int firstY = mathMax((int)ceil(sampleY - 0.5f - radius), tile.startY - border);
+                int lastY = mathMin((int)floor(sampleY - 0.5f + radius), tile.startY + tile.height + border - 1);
+
+                for(int splatY = firstY; splatY <= lastY; splatY++)
+                {
+                    for(int splatX = firstX; splatX <= lastX; splatX++)
+                    {
+                        float weight = filter.Evaluate(sampleX - (splatX + 0.5f), sampleY - (splatY + 0.5f));
+                        if(weight == 0.f) continue;
+
+                        float *splat = &splatBuffer[4 * ((splatY - tile.startY + border) * bufferWidth + (splatX - tile.startX + border))];
+                        splat[0] += weight * sampleColor.r;
+                        splat[1] += weight * sampleColor.g;
+                        splat[2] += weight * sampleColor.b;
+                        splat[3] += weight;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void Renderer::ResolveSplatBuffers(Camera *currentCamera, const TileScheduler &tileScheduler, const RenderTarget &target)
+{
+    int imageWidth = currentCamera->imageWidth;
+    int imageHeight = currentCamera->imageHeight;
+    int border = (int)ceil(target.filter->GetRadius() + 0.5f);
+
+    std::vector<float> sums(4 * imageWidth * imageHeight, 0.f);
+
+    for(size_t tileIndex = 0; tileIndex < tileScheduler.GetTileCount(); tileIndex++)
+    {
+        const Tile &tile = tileScheduler.GetTile(tileIndex);
+        const std::vector<float> &splatBuffer = (*target.splatBuffers)[tileIndex];
+
+        int bufferWidth = tile.width + 2 * border;
+
+        for(int y = mathMax(tile.startY - border, 0); y < mathMin(tile.startY + tile.height + border, imageHeight); y++)
+        {
+            for(int x = mathMax(tile.startX - border, 0); x < mathMin(tile.startX + tile.width + border, imageWidth); x++)
+            {
+                const float *splat = &splatBuffer[4 * ((y - tile.startY + border) * bufferWidth + (x - tile.startX + border))];
+                float *sum = &sums[4 * (y * imageWidth + x)];
+
+                sum[0] += splat[0];
+                sum[1] += splat[1];
+                sum[2] += splat[2];
+                sum[3] += splat[3];
+            }
+        }
+    }
+
+    // Negative lobes can cancel a pixel's weight, such pixels stay black
+    for(int pixelIndex = 0; pixelIndex < imageWidth * imageHeight; pixelIndex++)
+    {
+        float weight = sums[4 * pixelIndex + 3];
+        float oneOverWeight = weight > EPSILON ? 1.f / weight : 0.f;
+
+        target.colorBuffer[3 * pixelIndex    ] = sums[4 * pixelIndex    ] * oneOverWeight;
+        target.colorBuffer[3 * pixelIndex + 1] = sums[4 * pixelIndex + 1] * oneOverWeight;
+        target.colorBuffer[3 * pixelIndex + 2] = sums[4 * pixelIndex + 2] * oneOverWeight;
+    }
+}
+
+void Renderer::GetPixelSamplePosition(uint32_t sampleIndex, unsigned int strataCount, float &u, float &v)
+{
+    // A single sample goes through the pixel center
+    if(strataCount == 1 && sampleIndex == 0)
+    {
+        u = v = 0.5f;
+        return;
+    }
+
+    u = ((sampleIndex % strataCount) + RandomGenerator::GetSample(SAMPLE_PIXEL_DIMENSION)) / strataCount;
+    v = ((sampleIndex / strataCount) + RandomGenerator::GetSample(SAMPLE_PIXEL_DIMENSION + 1)) / strataCount;
+}
+
+Colorf Renderer::RenderFilteredPixel(unsigned int x, unsigned int y, const RendererInfo &ri, const Filter &filter)
+{
+    const Camera *camera = ri.camera;
+
+    uint32_t imagePixelIndex = y * camera->imageWidth + x;
+    unsigned int strataCount = mathMax((unsigned int)sqrt(camera->numberOfSamples), 1u);
+
+    Colorf pixelColor(0.f, 0.f, 0.f);
+    float weightSum = 0.f;
+
+    for(uint32_t sampleIndex = 0; sampleIndex < strataCount * strataCount; sampleIndex++)
+    {
+        RandomGenerator::StartSample(imagePixelIndex, sampleIndex, ri.frameIndex);
+
+        float u, v;
+        GetPixelSamplePosition(sampleIndex, strataCount, u, v);
+
+        float dx, dy, weight;
+
+        if(filter.GetMode() == FILTER_MODE::IMPORTANCE)
+        {
+            // The stratified position is warped to the filter's distribution
+            filter.SampleOffset(u, v, dx, dy, weight);
+        }
+        else
+        {
+            dx = u - 0.5f;
+            dy = v - 0.5f;
+            weight = filter.Evaluate(dx, dy);
+        }
+
+        if(weight == 0.f) continue;
+
+        pixelColor += weight * RenderPixel(x + 0.5f + dx, y + 0.5f + dy, ri);
+        weightSum += weight;
+    }
+
+    return weightSum > EPSILON ? pixelColor / weightSum : Colorf(0.f, 0.f, 0.f);
+}
+
+Colorf Renderer::RenderAdaptivePixel(unsigned int x, unsigned int y, const RendererInfo &ri, unsigned int &sampleCount)
+{
+    const Camera *camera = ri.camera;
+
+    uint32_t imagePixelIndex = y * camera->imageWidth + x;
+    unsigned int maxSampleCount = mathMax(camera->numberOfSamples, 1u);
+    unsigned int minSampleCount = mathClamp(camera->minSamples, 1u, maxSampleCount);
+
+    // Running mean of the color and Welford's mean and squared deviation sum of the luminance
+    Colorf meanColor(0.f, 0.f, 0.f);
+    float meanLuminance = 0.f;
+    float squaredDeviationSum = 0.f;
+
+    sampleCount = 0;
+
+    while(sampleCount < maxSampleCount)
+    {
+        RandomGenerator::StartSample(imagePixelIndex, sampleCount, ri.frameIndex);
+
+        float randomU = RandomGenerator::GetSample(SAMPLE_PIXEL_DIMENSION);
+        float randomV = RandomGenerator::GetSample(SAMPLE_PIXEL_DIMENSION + 1);
+
+        Colorf sampleColor = RenderPixel(x + randomU, y + randomV, ri);
+        float luminance = 0.27f * sampleColor.r + 0.67f * sampleColor.g + 0.06f * sampleColor.b;
+
+        sampleCount++;
+
+        float oneOverCount = 1.f / sampleCount;
+        meanColor += (sampleColor - meanColor) * oneOverCount;
+
+        float deviation = luminance - meanLuminance;
+        meanLuminance += deviation * oneOverCount;
+        squaredDeviationSum += deviation * (luminance - meanLuminance);
+
+        if(sampleCount >= minSampleCount && (sampleCount - minSampleCount) % ADAPTIVE_SAMPLE_BATCH_SIZE == 0)
+        {
+            // Standard error of the mean relative to the mean
+            float variance = squaredDeviationSum / mathMax(sampleCount - 1, 1u);
+            float standardError = sqrt(variance * oneOverCount);
+
+            if(standardError <= camera->noiseThreshold * mathMax(meanLuminance, ADAPTIVE_LUMINANCE_FLOOR))
+            {
+                break;
+            }
+        }
+    }
+
+    return meanColor;
+}
+
+Colorf Renderer::RenderPixel(float x, float y, const RendererInfo &ri)
+{
     float closestT = -1;
     float beta, gamma;
     Vector3 closestN = Vector3::ZeroVector;
@@ -261,11 +755,16 @@ Colorf Renderer::RenderPixel(float x, float y, const RendererInfo &ri)
 
     Colorf pixelColor = Colorf(0.f, 0.f, 0.f);
 
-    Ray ray(eye, d);
+    Ray ray = GetPrimaryRay(x, y, ri);
+
+    if(mainScene->integrator == INTEGRATOR::PATH_TRACER)
+    {
+        return Colorf(TracePath(ray));
+    }
 
     if(mainScene->SingleRayTrace(ray, closestT, closestN, beta, gamma, &closestObject))
     {
-        pixelColor = Colorf(CalculateShader(ShaderInfo(ray, closestObject, eye + d * closestT, closestN, beta, gamma)));
+        pixelColor = Colorf(CalculateShader(ShaderInfo(ray, closestObject, ray.e + ray.dir * closestT, closestN, beta, gamma)));
     }
     else
     {
@@ -304,106 +803,499 @@ Vector3 Renderer::CalculateShader(const ShaderInfo &shaderInfo, int recursionDep
         }
     }
 
+    Vector3 diffuseColor = GetDiffuseColor(shaderInfo.shadingObject, textureColor);
+
     Vector3 pixelColor = CalculateAmbientShader(shaderInfo.shadingObject->material->ambient, mainScene->ambientLight);
-    
-    for(Light *light : mainScene->lights)
+
+    pixelColor += CalculateDirectLighting(shaderInfo, diffuseColor);
+    pixelColor += CalculateSpecularTransport(shaderInfo, recursionDepth);
+
+    return pixelColor;
+}
+
+Vector3 Renderer::CalculateSpecularTransport(const ShaderInfo &shaderInfo, int recursionDepth)
+{
+    Vector3 specularColor = Vector3::ZeroVector;
+
+    if(shaderInfo.shadingObject->material->mirror != Vector3::ZeroVector)
     {
-        Vector3 lightPosition = light->GetPosition();
-        
-        Vector3 lightIntensity = light->GetIntensityAtPosition(lightPosition, shaderInfo.intersectionPoint);
-        Vector3 wi = -light->GetDirection(lightPosition, shaderInfo.intersectionPoint);
- 
-        if(shaderInfo.shadingObject->material->mirror != Vector3::ZeroVector)
+        specularColor += CalculateMirrorReflection(shaderInfo, recursionDepth);
+    }
+
+    if(shaderInfo.shadingObject->material->transparency != Vector3::ZeroVector)
+    {
+        specularColor += CalculateTransparency(shaderInfo, recursionDepth);
+    }
+
+    return specularColor;
+}
+
+Vector3 Renderer::TracePath(const Ray &cameraRay)
+{
+    // The whole state of the path, nothing is kept per vertex
+    Ray ray = cameraRay;
+    Vector3 throughput(1.f);
+    Vector3 radiance = Vector3::ZeroVector;
+
+    // Density the last bounce was sampled with, 0 for the camera ray and the specular bounces light sampling cannot produce
+    float bouncePdf = 0.f;
+
+    // Throughput of the light the last bounce hits, shaded at the previous vertex like a light sample
+    Vector3 emissionWeight = Vector3::ZeroVector;
+
+    // Normal at the previous vertex, the light BVH weighs the lights with it
+    Vector3 bounceNormal = Vector3::ZeroVector;
+
+    for(unsigned int depth = 0; depth < mainScene->maxRecursionDepth; depth++)
+    {
+        float hitT;
+        float beta, gamma;
+        Vector3 hitN;
+        const ObjectBase *hitObject = nullptr;
+
+        if(!mainScene->SingleRayTrace(ray, hitT, hitN, beta, gamma, &hitObject))
+        {
+            if(depth == 0)
+            {
+                radiance += Vector3(mainScene->bgColor.r, mainScene->bgColor.g, mainScene->bgColor.b);
+            }
+            break;
+        }
+
+        Vector3 intersectionPoint = ray.e + ray.dir * hitT;
+
+        if(const Light *hitLight = GetEmitter(hitObject))
+        {
+            if(bouncePdf > 0.f)
+            {
+                // Light sampling at the previous vertex could have found this point too
+                float lightPdf = hitLight->GetPdf(intersectionPoint, hitN, ray.e) * GetLightSampleCount(hitLight) * GetLightSelectionProbability(hitLight, ray.e, bounceNormal);
+                radiance += emissionWeight * hitLight->intensity * PowerHeuristic(bouncePdf, lightPdf);
+            }
+            else
+            {
+                radiance += throughput * hitLight->intensity;
+            }
+            break;
+        }
+
+        const Material *material = hitObject->material;
+        ShaderInfo shaderInfo(ray, hitObject, intersectionPoint, hitN, beta, gamma);
+
+        Vector3 textureColor = Vector3::ZeroVector;
+
+        if(hitObject->texture)
         {
-            pixelColor += CalculateMirrorReflection(shaderInfo, recursionDepth);
+            textureColor = hitObject->GetTextureColorAt(intersectionPoint, beta, gamma);
+
+            if(hitObject->texture->decalMode == DECAL_MODE::REPLACE_ALL)
+            {
+                radiance += throughput * textureColor;
+                break;
+            }
         }
 
-        if(shaderInfo.shadingObject->material->transparency != Vector3::ZeroVector)
+        Vector3 diffuseColor = GetDiffuseColor(hitObject, textureColor);
+
+        radiance += throughput * CalculateAmbientShader(material->ambient, mainScene->ambientLight);
+        radiance += throughput * CalculateDirectLighting(shaderInfo, diffuseColor, true);
+
+        if(depth + 1 >= mainScene->maxRecursionDepth)
         {
-            pixelColor += CalculateTransparency(shaderInfo, recursionDepth);
+            break;
         }
 
-        // If the intersection point is in a shadow area, then don't make further calculations
-        if (light->ShadowCheck(lightPosition, shaderInfo.intersectionPoint))
+        Vector3 origin, direction, weight;
+
+        if(!SampleContinuation(ray, intersectionPoint, hitN, material, diffuseColor, origin, direction, weight, bouncePdf))
         {
+            break;
+        }
+
+        if(bouncePdf > 0.f)
+        {
+            emissionWeight = throughput * CalculateSurfaceShader(shaderInfo, diffuseColor, -ray.dir, direction, Vector3(1.f)) / bouncePdf;
+        }
+
+        throughput = throughput * weight;
+
+        if(throughput.x <= 0.f && throughput.y <= 0.f && throughput.z <= 0.f)
+        {
+            break;
+        }
+
+        float survivalProbability;
+
+        if(!SurvivesRussianRoulette(depth, throughput, survivalProbability))
+        {
+            break;
+        }
+
+        throughput = throughput / survivalProbability;
+        emissionWeight = emissionWeight / survivalProbability;
+        bounceNormal = hitN;
+
+        ray = Ray(origin, direction);
+    }
+
+    return radiance;
+}
+
+bool Renderer::SurvivesRussianRoulette(unsigned int depth, const Vector3 &throughput, float &survivalProbability)
+{
+    survivalProbability = 1.f;
+
+    if(!mainScene->russianRoulette || depth + 1 < mainScene->russianRouletteMinDepth)
+    {
+        return true;
+    }
+
+    survivalProbability = mathMin(throughput.GetMaxComponent(), mainScene->maxSurvivalProbability);
+
+    return RandomGenerator::GetRandomFloat() < survivalProbability;
+}
+
+const Light *Renderer::GetEmitter(const ObjectBase *object)
+{
+    if(const LightMesh* lightMesh = dynamic_cast<const LightMesh *>(object->parentObject))
+    {
+        return lightMesh;
+    }
+
+    return dynamic_cast<const LightSphere *>(object);
+}
+
+void Renderer::SelectLights(const Vector3 &point, const Vector3 &normal, std::vector<LightSelection> &selections)
+{
+    selections.clear();
+
+    if(!mainScene->useLightBVH)
+    {
+        for(unsigned int lightIndex = 0; lightIndex < mainScene->lights.size(); lightIndex++)
+        {
+            selections.push_back(LightSelection{ lightIndex, 1.f });
+        }
+        return;
+    }
+
+    for(unsigned int lightIndex : mainScene->lightBVH.GetUnboundedLights())
+    {
+        selections.push_back(LightSelection{ lightIndex, 1.f });
+    }
+
+    unsigned int sampleCount = mathMax(1u, mainScene->lightBVHSampleCount);
+
+    for(unsigned int sampleIndex = 0; sampleIndex < sampleCount; sampleIndex++)
+    {
+        unsigned int lightIndex;
+        float probability;
+
+        if(mainScene->lightBVH.Sample(point, normal, RandomGenerator::GetRandomFloat(), lightIndex, probability))
+        {
+            selections.push_back(LightSelection{ lightIndex, probability * sampleCount });
+        }
+    }
+}
+
+float Renderer::GetLightSelectionProbability(const Light *light, const Vector3 &point, const Vector3 &normal)
+{
+    if(!mainScene->useLightBVH)
+    {
+        return 1.f;
+    }
+
+    return mainScene->lightBVH.GetProbability(point, normal, light) * mathMax(1u, mainScene->lightBVHSampleCount);
+}
+
+unsigned int Renderer::GetMaxSelectedLightCount()
+{
+    if(!mainScene->useLightBVH)
+    {
+        return mainScene->lights.size();
+    }
+
+    return mainScene->lightBVH.GetUnboundedLights().size() + mathMax(1u, mainScene->lightBVHSampleCount);
+}
+
+float Renderer::PowerHeuristic(float pdf, float otherPdf)
+{
+    float squaredPdf = pdf * pdf;
+    return squaredPdf / (squaredPdf + otherPdf * otherPdf);
+}
+
+Vector3 Renderer::GetDiffuseColor(const ObjectBase *object, Vector3 textureColor)
+{
+    if(!object->texture)
+    {
+        return object->material->diffuse;
+    }
+
+    textureColor /= object->texture->normalizer;
+    textureColor.Clamp(0.f, 1.f);
+
+    if(object->texture->decalMode == DECAL_MODE::REPLACE_KD)
+    {
+        return textureColor;
+    }
+
+    return (object->material->diffuse + textureColor) * 0.5f;
+}
+
+Vector3 Renderer::CalculateDirectLighting(const ShaderInfo &shaderInfo, const Vector3 &diffuseColor, bool weightLightSamples)
+{
+    Vector3 lightingColor = Vector3::ZeroVector;
+
+    // Direct lighting does not nest, so the selections of the thread can be reused
+    static thread_local std::vector<LightSelection> lightSelections;
+    SelectLights(shaderInfo.intersectionPoint + shaderInfo.shapeNormal * INTERSECTION_TEST_EPSILON, shaderInfo.shapeNormal, lightSelections);
+
+    // Shadow rays of all the lights are queued first and traced as one stream
+    size_t firstShadowRay = shadowRayStream.GetSize();
+
+    for(const LightSelection &selection : lightSelections)
+    {
+        unsigned int lightIndex = selection.lightIndex;
+        const Light *light = mainScene->lights[lightIndex];
+        unsigned int strataCount = GetLightStrataCount(light);
+
+        if(strataCount == 1 && !weightLightSamples)
+        {
+            shadowRayStream.Add(lightIndex, light->GetPosition(), shaderInfo.intersectionPoint);
             continue;
         }
 
-        Vector3 diffuseColor;
+        // One jittered sample in every cell of a strataCount x strataCount grid over the light
+        for(unsigned int strataV = 0; strataV < strataCount; strataV++)
+        {
+            for(unsigned int strataU = 0; strataU < strataCount; strataU++)
+            {
+                float u = (strataU + RandomGenerator::GetRandomFloat()) / strataCount;
+                float v = (strataV + RandomGenerator::GetRandomFloat()) / strataCount;
+
+                Vector3 lightNormal;
+                Vector3 lightPosition = light->SamplePosition(u, v, lightNormal);
+                float lightPdf = weightLightSamples ? light->GetPdf(lightPosition, lightNormal, shaderInfo.intersectionPoint) : 0.f;
+
+                shadowRayStream.Add(lightIndex, lightPosition, shaderInfo.intersectionPoint, lightPdf);
+            }
+        }
+    }
 
-        if(shaderInfo.shadingObject->texture)
+    shadowRayStream.Trace(firstShadowRay);
+
+    const Material *material = shaderInfo.shadingObject->material;
+
+    Vector3 wo = shaderInfo.ray.e - shaderInfo.intersectionPoint;
+    wo.Normalize();
+
+    size_t shadowRayIndex = firstShadowRay;
+
+    for(const LightSelection &selection : lightSelections)
+    {
+        const Light *light = mainScene->lights[selection.lightIndex];
+        unsigned int sampleCount = GetLightSampleCount(light);
+
+        // Samples the light is expected to get at the point, its own samples times how often it is picked
+        float expectedSampleCount = sampleCount * selection.probability;
+        float sampleWeight = 1.f / expectedSampleCount;
+
+        for(unsigned int sampleIndex = 0; sampleIndex < sampleCount; sampleIndex++, shadowRayIndex++)
         {
-            textureColor /= shaderInfo.shadingObject->texture->normalizer;
-            textureColor.Clamp(0.f, 1.f);
+            // If the intersection point is in a shadow area, then don't make further calculations
+            if (shadowRayStream.IsOccluded(shadowRayIndex))
+            {
+                continue;
+            }
+
+            Vector3 lightPosition = shadowRayStream.GetLightPosition(shadowRayIndex);
+            Vector3 wi = -light->GetDirection(lightPosition, shaderInfo.intersectionPoint);
 
-            if(shaderInfo.shadingObject->texture->decalMode == DECAL_MODE::REPLACE_KD)
+            Vector3 lightIntensity;
+            float lightPdf = shadowRayStream.GetLightPdf(shadowRayIndex);
+
+            if(lightPdf > 0.f)
+            {
+                // Emitted radiance over the sample's density, weighted against the path's bounce finding the same point
+                float bouncePdf = GetContinuationPdf(material, diffuseColor, shaderInfo.shapeNormal, wo, wi);
+                lightIntensity = light->intensity * (PowerHeuristic(expectedSampleCount * lightPdf, bouncePdf) / (expectedSampleCount * lightPdf));
+            }
+            else if(weightLightSamples && light->IsEmissiveGeometry())
             {
-                diffuseColor = textureColor;
+                // The sample is on the light's side turned away from the point
+                continue;
             }
             else
             {
-                diffuseColor = (shaderInfo.shadingObject->material->diffuse + textureColor) * 0.5f;
+                lightIntensity = light->GetIntensityAtPosition(lightPosition, shaderInfo.intersectionPoint) * sampleWeight;
             }
+
+            lightingColor += CalculateSurfaceShader(shaderInfo, diffuseColor, wo, wi, lightIntensity);
         }
-        else
+    }
+
+    shadowRayStream.Truncate(firstShadowRay);
+
+    return lightingColor;
+}
+
+Vector3 Renderer::CalculateSurfaceShader(const ShaderInfo &shaderInfo, const Vector3 &diffuseColor, const Vector3 &wo, const Vector3 &wi, const Vector3 &lightIntensity)
+{
+    const Material *material = shaderInfo.shadingObject->material;
+
+    if(material->brdf)
+    {
+        return material->brdf->GetBRDF(diffuseColor, material->specular, shaderInfo.shapeNormal, wo, wi) * lightIntensity;
+    }
+
+    return CalculateDiffuseShader(shaderInfo, diffuseColor, wi, lightIntensity) + CalculateSpecularShader(shaderInfo, wi, lightIntensity);
+}
+
+float Renderer::GetContinuationPdf(const Material *material, const Vector3 &diffuseColor, const Vector3 &normal, const Vector3 &wo, const Vector3 &wi)
+{
+    float surfaceWeight = GetSurfaceWeight(material, diffuseColor);
+    float totalWeight = surfaceWeight + material->mirror.GetMaxComponent() + material->transparency.GetMaxComponent();
+
+    float cosTetha = Vector3::Dot(wi, normal);
+
+    if(totalWeight <= 0.f || cosTetha <= 0.f)
+    {
+        return 0.f;
+    }
+
+    if(material->brdf)
+    {
+        return surfaceWeight * material->brdf->Pdf(diffuseColor, material->specular, normal, wo, wi) / totalWeight;
+    }
+
+    if(mainScene->integratorParams == INTEGRATOR_PARAMS::IMPORTANCE_SAMPLING)
+    {
+        return surfaceWeight * cosTetha / (totalWeight * PI);
+    }
+
+    return surfaceWeight / (totalWeight * TWO_PI);
+}
+
+bool Renderer::SampleContinuation(const Ray &ray, const Vector3 &intersectionPoint, const Vector3 &normal, const Material *material, const Vector3 &diffuseColor, Vector3 &origin, Vector3 &direction, Vector3 &weight, float &pdf)
+{
+    pdf = 0.f;
+
+    float surfaceWeight = GetSurfaceWeight(material, diffuseColor);
+    float mirrorWeight = material->mirror.GetMaxComponent();
+    float transparencyWeight = material->transparency.GetMaxComponent();
+    float totalWeight = surfaceWeight + mirrorWeight + transparencyWeight;
+
+    if(totalWeight <= 0.f)
+    {
+        return false;
+    }
+
+    float lobeSelection = RandomGenerator::GetRandomFloat() * totalWeight;
+
+    if(lobeSelection < surfaceWeight)
+    {
+        origin = intersectionPoint + normal * INTERSECTION_TEST_EPSILON;
+
+        if(material->brdf)
         {
-            diffuseColor = shaderInfo.shadingObject->material->diffuse;
-        }
+            // The BRDF picks between its diffuse and specular lobes itself
+            Vector3 value;
+            float brdfPdf;
+
+            if(!material->brdf->Sample(diffuseColor, material->specular, normal, -ray.dir, direction, value, brdfPdf))
+            {
+                return false;
+            }
 
-        if(shaderInfo.shadingObject->material->brdf)
+            weight = value * (totalWeight / (surfaceWeight * brdfPdf));
+            pdf = surfaceWeight * brdfPdf / totalWeight;
+        }
+        else if(mainScene->integratorParams == INTEGRATOR_PARAMS::IMPORTANCE_SAMPLING)
         {
-            Vector3 wo = shaderInfo.ray.e - shaderInfo.intersectionPoint;
-            wo.Normalize();
-            
-            pixelColor += shaderInfo.shadingObject->material->brdf->GetBRDF(diffuseColor, shaderInfo.shadingObject->material->specular, shaderInfo.shapeNormal, wo, wi) * lightIntensity;
+            // Cosine weighted once the diffuse lobe is picked, the cosine cancels against the density
+            direction = Ray::GetCosineWeightedHemiSphericalDirection(normal);
+
+            float cosTetha = Vector3::Dot(direction, normal);
+
+            if(cosTetha <= 0.f)
+            {
+                return false;
+            }
+
+            weight = diffuseColor * (PI * totalWeight / surfaceWeight);
+            pdf = surfaceWeight * cosTetha / (totalWeight * PI);
         }
         else
         {
-            pixelColor += CalculateDiffuseShader(shaderInfo, diffuseColor, wi, lightIntensity);
-            pixelColor += CalculateSpecularShader(shaderInfo, wi, lightIntensity);
+            // Uniform over the hemisphere once the diffuse lobe is picked, the cosine stays in the weight
+            direction = Ray::GetRandomHemiSphericalDirection(normal);
+
+            float cosTetha = Vector3::Dot(direction, normal);
+
+            if(cosTetha <= 0.f)
+            {
+                return false;
+            }
+
+            weight = diffuseColor * (cosTetha * TWO_PI * totalWeight / surfaceWeight);
+            pdf = surfaceWeight / (totalWeight * TWO_PI);
         }
     }
+    else if(lobeSelection < surfaceWeight + mirrorWeight)
+    {
+        direction = ray.dir - 2 * normal * Vector3::Dot(ray.dir, normal);
+        direction.Normalize();
 
-    if(mainScene->integrator == INTEGRATOR::PATH_TRACER)
+        if(material->roughness != 0.f)
+        {
+            direction = Ray::GetRandomDirection(direction);
+        }
+
+        origin = intersectionPoint + direction * INTERSECTION_TEST_EPSILON;
+        weight = material->mirror * (totalWeight / mirrorWeight);
+    }
+    else
     {
-        Vector3 indirectLightContribution = Vector3::ZeroVector;
-        for(unsigned int bounceIndex = 0; bounceIndex < mainScene->pathTracingBounceCount; bounceIndex++)
+        // Refraction or Fresnel reflection, picked with the Schlick approximation as probability
+        Vector3 facingNormal = normal;
+        float eta = 1.f / material->refractionIndex;
+        float cosI = -Vector3::Dot(ray.dir, normal);
+
+        if(cosI < 0.f)
         {
-            float bounceT;
-            Vector3 bounceN;
-            float bounceBeta, bounceGamma;
-            const ObjectBase *bounceIntersectingObject;
+            facingNormal = -normal;
+            eta = material->refractionIndex;
+            cosI = -cosI;
+        }
 
-            Vector3 randomRayDirection = Ray::GetRandomHemiSphericalDirection(shaderInfo.shapeNormal);
+        float k = 1.f - eta * eta * (1.f - cosI * cosI);
+        bool refracts = false;
 
-            float cosTetha = Vector3::Dot(randomRayDirection, shaderInfo.shapeNormal);
+        if(k >= 0.f)
+        {
+            float cosT = sqrt(k);
+            float R0 = pow(material->refractionIndex - 1, 2) / pow(material->refractionIndex + 1, 2);
+            float fresnel = R0 + (1 - R0) * pow(1 - (eta < 1.f ? cosI : cosT), 5);
 
-            Ray bounceRay(shaderInfo.intersectionPoint + shaderInfo.shapeNormal * INTERSECTION_TEST_EPSILON, randomRayDirection);
-            if(mainScene->SingleRayTrace(bounceRay, bounceT, bounceN, bounceBeta, bounceGamma, &bounceIntersectingObject))
+            if(RandomGenerator::GetRandomFloat() >= fresnel)
             {
-                Vector3 indirectShaderValue = CalculateShader(ShaderInfo(bounceRay, bounceIntersectingObject, bounceRay.e + bounceRay.dir * bounceT, bounceN, bounceBeta, bounceGamma), ++recursionDepth);
-                
-                if(mainScene->integratorParams == INTEGRATOR_PARAMS::IMPORTANCE_SAMPLING)
-                {
-                    indirectShaderValue *= cosTetha * TWO_PI;
-                }
-                else
-                {
-                    indirectShaderValue *= TWO_PI;
-                }
-
-                indirectLightContribution += indirectShaderValue;
+                direction = ray.dir * eta + facingNormal * (eta * cosI - cosT);
+                direction.Normalize();
+                origin = intersectionPoint - facingNormal * INTERSECTION_TEST_EPSILON;
+                refracts = true;
             }
         }
-        //indirectLightContribution *= 2.0f;
-        indirectLightContribution /= (float)mainScene->pathTracingBounceCount;
-        indirectLightContribution.Clamp(0, 255);
-        //pixelColor /= PI;
 
-        pixelColor += shaderInfo.shadingObject->material->diffuse * indirectLightContribution;
+        if(!refracts)
+        {
+            direction = ray.dir + 2 * facingNormal * cosI;
+            direction.Normalize();
+            origin = intersectionPoint + facingNormal * INTERSECTION_TEST_EPSILON;
+        }
+
+        weight = material->transparency * (totalWeight / transparencyWeight);
     }
 
-    return pixelColor;
+    return true;
 }
 
 Vector3 Renderer::CalculateAmbientShader(const Vector3& ambientReflectance, const Vector3& intensity)
@@ -515,10 +1407,13 @@ Vector3 Renderer::CalculateRefraction(const ShaderInfo &shaderInfo, float &fresn
     
     Vector3 o = shaderInfo.intersectionPoint - normal * INTERSECTION_TEST_EPSILON;
 
-    if(mainScene->SingleRayTrace(Ray(o, t), hitT, hitN, beta, gamma, &hitObject))
+    // ShaderInfo keeps a reference to the ray, so it has to outlive the shading call
+    Ray refractedRay(o, t);
+
+    if(mainScene->SingleRayTrace(refractedRay, hitT, hitN, beta, gamma, &hitObject))
     {
         Vector3 nextIntersectionPoint = shaderInfo.intersectionPoint + hitT * t;
-        ShaderInfo reflectedShaderInfo(Ray(o, t), hitObject, nextIntersectionPoint, hitN);
+        ShaderInfo reflectedShaderInfo(refractedRay, hitObject, nextIntersectionPoint, hitN);
 
         return /* attenuation *  */CalculateShader(reflectedShaderInfo, ++recursionDepth);
     }
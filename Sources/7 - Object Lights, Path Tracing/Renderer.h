@@ -7,17 +7,23 @@
 #ifndef __RENDERER_H__
 #define __RENDERER_H__
 
+#include <vector>
+
 #include "Camera.h"
 #include "Color.h"
 #include "Math.h"
 #include "Ray.h"
 
 class Light;
+struct LightSelection;
+class Material;
 class ObjectBase;
+class TileScheduler;
+struct Tile;
 
 struct RendererInfo
 {
-    RendererInfo(const Camera *cam) :
+    RendererInfo(const Camera *cam, unsigned int frame = 0) :
         e(cam->position),
         w(cam->gaze),
         u(cam->right),
@@ -27,7 +33,8 @@ struct RendererInfo
         b(cam->nearPlane.z),
         t(cam->nearPlane.w),
         distance(cam->nearDistance),
-        camera(cam)
+        camera(cam),
+        frameIndex(frame)
     {
         m = e + (w * distance);
         q = m + u * l + v * t;
@@ -38,6 +45,24 @@ struct RendererInfo
     float l, r, b, t; 
     float distance;  
     const Camera *camera;
+
+    // Decorrelates the random sequences of the cameras
+    unsigned int frameIndex;
+};
+
+// Buffers the tiles of a camera are rendered into
+struct RenderTarget
+{
+    float *colorBuffer = nullptr;
+
+    // Sample count of every pixel when the camera samples adaptively
+    unsigned int *sampleCountBuffer = nullptr;
+
+    // Reconstruction filter of the camera, nullptr keeps the centre sample and Gaussian weighting
+    const Filter *filter = nullptr;
+
+    // Weighted sums of every tile and its border in splat mode, indexed by tile
+    std::vector<std::vector<float>> *splatBuffers = nullptr;
 };
 
 struct ShaderInfo
@@ -74,6 +99,9 @@ public:
     // Renderer function
     static void RenderScene();
 
+    // Creates the camera ray passing through the image plane position (x, y)
+    static Ray GetPrimaryRay(float x, float y, const RendererInfo &ri);
+
     // Calculates pixel color recursively
     static Vector3 CalculateShader(const ShaderInfo &si, int recursionDepth = 0);
     
@@ -97,11 +125,86 @@ public:
 
     // Calculate transparency
     static Vector3 CalculateTransparency(const ShaderInfo& si, unsigned int recursionDepth = 0);
+
+    // Reflected color of the light arriving from wi with the given intensity
+    static Vector3 CalculateSurfaceShader(const ShaderInfo &shaderInfo, const Vector3 &diffuseColor, const Vector3 &wo, const Vector3 &wi, const Vector3 &lightIntensity);
+
+    // Picks the lobe the path continues with proportional to its reflectance, weight is the lobe's throughput factor
+    // Materials with a BRDF sample their directions from it, the others from their diffuse term
+    // pdf is the solid angle density of the direction, 0 for the specular lobes light sampling cannot produce
+    // Returns false when the surface reflects nothing and the path ends
+    static bool SampleContinuation(const Ray &ray, const Vector3 &intersectionPoint, const Vector3 &normal, const Material *material, const Vector3 &diffuseColor, Vector3 &origin, Vector3 &direction, Vector3 &weight, float &pdf);
+
+    // Density of SampleContinuation picking wi, leaving out the specular lobes
+    static float GetContinuationPdf(const Material *material, const Vector3 &diffuseColor, const Vector3 &normal, const Vector3 &wo, const Vector3 &wi);
+
+    // Russian roulette on the continuation ray of a vertex at depth
+    // Returns false when the path ends, survivors' throughput has to be divided by survivalProbability
+    static bool SurvivesRussianRoulette(unsigned int depth, const Vector3 &throughput, float &survivalProbability);
+
+    // Multiple importance sampling weight of a sample drawn with pdf, against a strategy with otherPdf for the same sample
+    static float PowerHeuristic(float pdf, float otherPdf);
+
+    // The light the object emits as, nullptr when it is not part of a light mesh or a light sphere
+    static const Light *GetEmitter(const ObjectBase *object);
+
+    // Replaces selections with the lights the point is shaded with, every light unless the scene samples them from its light BVH
+    // point is where the diffuse bounce leaves from, so the bounce's hit looks the probabilities up from its ray origin
+    static void SelectLights(const Vector3 &point, const Vector3 &normal, std::vector<LightSelection> &selections);
+
+    // Expected number of times SelectLights picks the light at the point
+    static float GetLightSelectionProbability(const Light *light, const Vector3 &point, const Vector3 &normal);
+
+    // Most lights SelectLights picks for a point
+    static unsigned int GetMaxSelectedLightCount();
     
 private:
-    static void ThreadFunction(Camera *currentCamera, int startX, int startY, int width, int height, /* unsigned char */ float *colorBuffer);
+    // Follows the camera ray's path one vertex at a time with a running throughput, no rays branch off
+    static Vector3 TracePath(const Ray &cameraRay);
+
+    // Diffuse reflectance of the object with the raw texture color applied
+    static Vector3 GetDiffuseColor(const ObjectBase *object, Vector3 textureColor);
+
+    // Shades the point with the lights SelectLights picks, shadow rays are queued first and traced as one stream
+    // Light samples are weighted against the path's bounces when weightLightSamples is set, the lights the bounces can hit are sampled by area then
+    static Vector3 CalculateDirectLighting(const ShaderInfo &shaderInfo, const Vector3 &diffuseColor, bool weightLightSamples = false);
+
+    // Traces the hit's mirror reflection and refraction once, no matter how many lights shade it directly
+    static Vector3 CalculateSpecularTransport(const ShaderInfo &shaderInfo, int recursionDepth);
+
+    // Renders the camera's image, tone maps it and queues it for output
+    static void RenderCamera(Camera *currentCamera);
+
+    // Refines the camera's image in passes until its sample count or time budget is reached
+    static void RenderProgressive(Camera *currentCamera, float *image);
+
+    // Adds sampleCount samples starting at firstSample to the sums of the tile's pixels
+    static void RenderProgressiveTile(Camera *currentCamera, const RendererInfo &ri, const Tile &tile, float *accumulationBuffer, unsigned int firstSample, unsigned int sampleCount);
+
+    // Returns the tone mapped copy of the image, nullptr when the camera has no tone mapping
+    static float *ToneMapImage(const Camera *currentCamera, const float *image);
+
+    // Renders the tiles the scheduler hands out to the thread until none is left
+    static void ThreadFunction(Camera *currentCamera, TileScheduler *tileScheduler, unsigned int threadIndex, const RenderTarget &target);
+    static void RenderTile(Camera *currentCamera, const RendererInfo &ri, const Tile &tile, const RenderTarget &target);
+
+    // Adds the samples of the tile's pixels to the tile's splat buffer
+    static void RenderSplatTile(Camera *currentCamera, const RendererInfo &ri, const Tile &tile, const RenderTarget &target);
+
+    // Sums the splat buffers in tile order, so the result does not depend on which thread rendered what
+    static void ResolveSplatBuffers(Camera *currentCamera, const TileScheduler &tileScheduler, const RenderTarget &target);
+
     static Colorf RenderPixel(float x, float y, const RendererInfo &ri);
 
+    // Returns the position of the pixel's sample in [0, 1)^2, stratified on a grid of strataCount^2 cells
+    static void GetPixelSamplePosition(uint32_t sampleIndex, unsigned int strataCount, float &u, float &v);
+
+    // Weights the pixel's samples with the camera's filter
+    static Colorf RenderFilteredPixel(unsigned int x, unsigned int y, const RendererInfo &ri, const Filter &filter);
+
+    // Samples the pixel until its relative standard error drops below the camera's threshold
+    static Colorf RenderAdaptivePixel(unsigned int x, unsigned int y, const RendererInfo &ri, unsigned int &sampleCount);
+
 };
 
 #endif
\ No newline at end of file
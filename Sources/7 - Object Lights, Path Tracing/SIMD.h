@@ -0,0 +1,460 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#ifndef __SIMD_H__
+#define __SIMD_H__
+
+#include "Math.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#define SIMD_AVX
+#include <immintrin.h>
+#endif
+
+/*
+    SIMD packet types, the matrix products and the shadow ray packets are computed with them
+    Every lane is computed with the same IEEE operations in the same order as the scalar code,
+    so a lane of a packet result is bit for bit equal to the matching Vector3 / float result
+    Approximate instructions (rcp, rsqrt) and fused multiply-add are not used for that reason
+*/
+
+struct Float4;
+struct Mask4;
+
+/*
+    4 lane boolean mask, result of Float4 comparisons
+*/
+struct Mask4
+{
+#ifdef SIMD_SSE
+    Mask4()
+    {
+
+    }
+
+    Mask4(__m128 value) : v(value)
+    {
+
+    }
+
+    inline Mask4 operator&(const Mask4 &rhs) const { return _mm_and_ps(v, rhs.v); }
+    inline Mask4 operator|(const Mask4 &rhs) const { return _mm_or_ps(v, rhs.v); }
+    inline Mask4 operator^(const Mask4 &rhs) const { return _mm_xor_ps(v, rhs.v); }
+    inline Mask4 operator!() const { return _mm_xor_ps(v, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+
+    // Lane i is true when bit i is set
+    static inline Mask4 FromBits(int bits)
+    {
+        const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+        return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), laneBits), laneBits));
+    }
+
+    // Bit i is set when lane i is true
+    inline int GetBits() const { return _mm_movemask_ps(v); }
+
+    __m128 v;
+#else
+    Mask4()
+    {
+
+    }
+
+    inline Mask4 operator&(const Mask4 &rhs) const { Mask4 out; for(int i = 0; i < 4; i++) out.lanes[i] = lanes[i] && rhs.lanes[i]; return out; }
+    inline Mask4 operator|(const Mask4 &rhs) const { Mask4 out; for(int i = 0; i < 4; i++) out.lanes[i] = lanes[i] || rhs.lanes[i]; return out; }
+    inline Mask4 operator^(const Mask4 &rhs) const { Mask4 out; for(int i = 0; i < 4; i++) out.lanes[i] = lanes[i] != rhs.lanes[i]; return out; }
+    inline Mask4 operator!() const { Mask4 out; for(int i = 0; i < 4; i++) out.lanes[i] = !lanes[i]; return out; }
+
+    static inline Mask4 FromBits(int bits) { Mask4 out; for(int i = 0; i < 4; i++) out.lanes[i] = (bits >> i) & 1; return out; }
+
+    inline int GetBits() const { int bits = 0; for(int i = 0; i < 4; i++) bits |= lanes[i] ? 1 << i : 0; return bits; }
+
+    bool lanes[4];
+#endif
+
+    inline bool Any() const { return GetBits() != 0; }
+    inline bool All() const { return GetBits() == 0xf; }
+    inline bool None() const { return GetBits() == 0; }
+    inline bool operator[](int index) const { return (GetBits() >> index) & 1; }
+};
+
+/*
+    4 lane float packet
+*/
+struct Float4
+{
+    static const int Width = 4;
+
+    typedef Mask4 Mask;
+
+#ifdef SIMD_SSE
+    Float4()
+    {
+
+    }
+
+    Float4(__m128 value) : v(value)
+    {
+
+    }
+
+    Float4(float value) : v(_mm_set1_ps(value))
+    {
+
+    }
+
+    Float4(float x, float y, float z, float w) : v(_mm_setr_ps(x, y, z, w))
+    {
+
+    }
+
+    static inline Float4 Load(const float *values) { return _mm_loadu_ps(values); }
+    inline void Store(float *values) const { _mm_storeu_ps(values, v); }
+
+    inline float operator[](int index) const { float values[4]; Store(values); return values[index]; }
+
+    inline Float4 operator-() const { return _mm_xor_ps(v, _mm_set1_ps(-0.f)); }
+    inline Float4 operator+(const Float4 &rhs) const { return _mm_add_ps(v, rhs.v); }
+    inline Float4 operator-(const Float4 &rhs) const { return _mm_sub_ps(v, rhs.v); }
+    inline Float4 operator*(const Float4 &rhs) const { return _mm_mul_ps(v, rhs.v); }
+    inline Float4 operator/(const Float4 &rhs) const { return _mm_div_ps(v, rhs.v); }
+
+    inline Mask4 operator<(const Float4 &rhs) const { return _mm_cmplt_ps(v, rhs.v); }
+    inline Mask4 operator<=(const Float4 &rhs) const { return _mm_cmple_ps(v, rhs.v); }
+    inline Mask4 operator>(const Float4 &rhs) const { return _mm_cmpgt_ps(v, rhs.v); }
+    inline Mask4 operator>=(const Float4 &rhs) const { return _mm_cmpge_ps(v, rhs.v); }
+    inline Mask4 operator==(const Float4 &rhs) const { return _mm_cmpeq_ps(v, rhs.v); }
+    inline Mask4 operator!=(const Float4 &rhs) const { return _mm_cmpneq_ps(v, rhs.v); }
+
+    // Operands ordered to match mathMin / mathMax, so NaN lanes resolve the same way
+    static inline Float4 Min(const Float4 &f, const Float4 &s) { return _mm_min_ps(s.v, f.v); }
+    static inline Float4 Max(const Float4 &f, const Float4 &s) { return _mm_max_ps(f.v, s.v); }
+    static inline Float4 Sqrt(const Float4 &value) { return _mm_sqrt_ps(value.v); }
+    static inline Float4 Abs(const Float4 &value) { return _mm_andnot_ps(_mm_set1_ps(-0.f), value.v); }
+
+    // Lanes of ifTrue where the mask is set, lanes of ifFalse elsewhere
+    static inline Float4 Select(const Mask4 &mask, const Float4 &ifTrue, const Float4 &ifFalse)
+    {
+        return _mm_or_ps(_mm_and_ps(mask.v, ifTrue.v), _mm_andnot_ps(mask.v, ifFalse.v));
+    }
+
+    __m128 v;
+#else
+    Float4()
+    {
+
+    }
+
+    Float4(float value)
+    {
+        for(int i = 0; i < 4; i++) lanes[i] = value;
+    }
+
+    Float4(float x, float y, float z, float w)
+    {
+        lanes[0] = x;
+        lanes[1] = y;
+        lanes[2] = z;
+        lanes[3] = w;
+    }
+
+    static inline Float4 Load(const float *values) { return Float4(values[0], values[1], values[2], values[3]); }
+    inline void Store(float *values) const { for(int i = 0; i < 4; i++) values[i] = lanes[i]; }
+
+    inline float operator[](int index) const { return lanes[index]; }
+
+    inline Float4 operator-() const { return Float4(-lanes[0], -lanes[1], -lanes[2], -lanes[3]); }
+    inline Float4 operator+(const Float4 &rhs) const { return Float4(lanes[0] + rhs.lanes[0], lanes[1] + rhs.lanes[1], lanes[2] + rhs.lanes[2], lanes[3] + rhs.lanes[3]); }
+    inline Float4 operator-(const Float4 &rhs) const { return Float4(lanes[0] - rhs.lanes[0], lanes[1] - rhs.lanes[1], lanes[2] - rhs.lanes[2], lanes[3] - rhs.lanes[3]); }
+    inline Float4 operator*(const Float4 &rhs) const { return Float4(lanes[0] * rhs.lanes[0], lanes[1] * rhs.lanes[1], lanes[2] * rhs.lanes[2], lanes[3] * rhs.lanes[3]); }
+    inline Float4 operator/(const Float4 &rhs) const { return Float4(lanes[0] / rhs.lanes[0], lanes[1] / rhs.lanes[1], lanes[2] / rhs.lanes[2], lanes[3] / rhs.lanes[3]); }
+
+    inline Mask4 operator<(const Float4 &rhs) const { Mask4 out; for(int i = 0; i < 4; i++) out.lanes[i] = lanes[i] < rhs.lanes[i]; return out; }
+    inline Mask4 operator<=(const Float4 &rhs) const { Mask4 out; for(int i = 0; i < 4; i++) out.lanes[i] = lanes[i] <= rhs.lanes[i]; return out; }
+    inline Mask4 operator>(const Float4 &rhs) const { Mask4 out; for(int i = 0; i < 4; i++) out.lanes[i] = lanes[i] > rhs.lanes[i]; return out; }
+    inline Mask4 operator>=(const Float4 &rhs) const { Mask4 out; for(int i = 0; i < 4; i++) out.lanes[i] = lanes[i] >= rhs.lanes[i]; return out; }
+    inline Mask4 operator==(const Float4 &rhs) const { Mask4 out; for(int i = 0; i < 4; i++) out.lanes[i] = lanes[i] == rhs.lanes[i]; return out; }
+    inline Mask4 operator!=(const Float4 &rhs) const { Mask4 out; for(int i = 0; i < 4; i++) out.lanes[i] = lanes[i] != rhs.lanes[i]; return out; }
+
+    static inline Float4 Min(const Float4 &f, const Float4 &s) { Float4 out; for(int i = 0; i < 4; i++) out.lanes[i] = mathMin(f.lanes[i], s.lanes[i]); return out; }
+    static inline Float4 Max(const Float4 &f, const Float4 &s) { Float4 out; for(int i = 0; i < 4; i++) out.lanes[i] = mathMax(f.lanes[i], s.lanes[i]); return out; }
+    static inline Float4 Sqrt(const Float4 &value) { Float4 out; for(int i = 0; i < 4; i++) out.lanes[i] = sqrtf(value.lanes[i]); return out; }
+    static inline Float4 Abs(const Float4 &value) { Float4 out; for(int i = 0; i < 4; i++) out.lanes[i] = std::fabs(value.lanes[i]); return out; }
+
+    static inline Float4 Select(const Mask4 &mask, const Float4 &ifTrue, const Float4 &ifFalse)
+    {
+        Float4 out;
+        for(int i = 0; i < 4; i++) out.lanes[i] = mask.lanes[i] ? ifTrue.lanes[i] : ifFalse.lanes[i];
+        return out;
+    }
+
+    float lanes[4];
+#endif
+
+    inline void operator+=(const Float4 &rhs) { *this = *this + rhs; }
+    inline void operator-=(const Float4 &rhs) { *this = *this - rhs; }
+    inline void operator*=(const Float4 &rhs) { *this = *this * rhs; }
+    inline void operator/=(const Float4 &rhs) { *this = *this / rhs; }
+};
+
+/*
+    8 lane boolean mask, result of Float8 comparisons
+*/
+struct Mask8
+{
+#ifdef SIMD_AVX
+    Mask8()
+    {
+
+    }
+
+    Mask8(__m256 value) : v(value)
+    {
+
+    }
+
+    inline Mask8 operator&(const Mask8 &rhs) const { return _mm256_and_ps(v, rhs.v); }
+    inline Mask8 operator|(const Mask8 &rhs) const { return _mm256_or_ps(v, rhs.v); }
+    inline Mask8 operator^(const Mask8 &rhs) const { return _mm256_xor_ps(v, rhs.v); }
+    inline Mask8 operator!() const { return _mm256_xor_ps(v, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+
+    // Built from two halves, AVX has no 256 bit integer compare
+    static inline Mask8 FromBits(int bits)
+    {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(Mask4::FromBits(bits).v), Mask4::FromBits(bits >> 4).v, 1);
+    }
+
+    inline int GetBits() const { return _mm256_movemask_ps(v); }
+
+    __m256 v;
+#else
+    Mask8()
+    {
+
+    }
+
+    Mask8(const Mask4 &low, const Mask4 &high) : lo(low), hi(high)
+    {
+
+    }
+
+    inline Mask8 operator&(const Mask8 &rhs) const { return Mask8(lo & rhs.lo, hi & rhs.hi); }
+    inline Mask8 operator|(const Mask8 &rhs) const { return Mask8(lo | rhs.lo, hi | rhs.hi); }
+    inline Mask8 operator^(const Mask8 &rhs) const { return Mask8(lo ^ rhs.lo, hi ^ rhs.hi); }
+    inline Mask8 operator!() const { return Mask8(!lo, !hi); }
+
+    static inline Mask8 FromBits(int bits) { return Mask8(Mask4::FromBits(bits), Mask4::FromBits(bits >> 4)); }
+
+    inline int GetBits() const { return lo.GetBits() | (hi.GetBits() << 4); }
+
+    // Lanes 0-3 and 4-7
+    Mask4 lo, hi;
+#endif
+
+    inline bool Any() const { return GetBits() != 0; }
+    inline bool All() const { return GetBits() == 0xff; }
+    inline bool None() const { return GetBits() == 0; }
+    inline bool operator[](int index) const { return (GetBits() >> index) & 1; }
+};
+
+/*
+    8 lane float packet
+    Uses AVX when the compiler targets it, a pair of Float4 otherwise
+*/
+struct Float8
+{
+    static const int Width = 8;
+
+    typedef Mask8 Mask;
+
+#ifdef SIMD_AVX
+    Float8()
+    {
+
+    }
+
+    Float8(__m256 value) : v(value)
+    {
+
+    }
+
+    Float8(float value) : v(_mm256_set1_ps(value))
+    {
+
+    }
+
+    static inline Float8 Load(const float *values) { return _mm256_loadu_ps(values); }
+    inline void Store(float *values) const { _mm256_storeu_ps(values, v); }
+
+    inline Float8 operator-() const { return _mm256_xor_ps(v, _mm256_set1_ps(-0.f)); }
+    inline Float8 operator+(const Float8 &rhs) const { return _mm256_add_ps(v, rhs.v); }
+    inline Float8 operator-(const Float8 &rhs) const { return _mm256_sub_ps(v, rhs.v); }
+    inline Float8 operator*(const Float8 &rhs) const { return _mm256_mul_ps(v, rhs.v); }
+    inline Float8 operator/(const Float8 &rhs) const { return _mm256_div_ps(v, rhs.v); }
+
+    inline Mask8 operator<(const Float8 &rhs) const { return _mm256_cmp_ps(v, rhs.v, _CMP_LT_OQ); }
+    inline Mask8 operator<=(const Float8 &rhs) const { return _mm256_cmp_ps(v, rhs.v, _CMP_LE_OQ); }
+    inline Mask8 operator>(const Float8 &rhs) const { return _mm256_cmp_ps(v, rhs.v, _CMP_GT_OQ); }
+    inline Mask8 operator>=(const Float8 &rhs) const { return _mm256_cmp_ps(v, rhs.v, _CMP_GE_OQ); }
+    inline Mask8 operator==(const Float8 &rhs) const { return _mm256_cmp_ps(v, rhs.v, _CMP_EQ_OQ); }
+    inline Mask8 operator!=(const Float8 &rhs) const { return _mm256_cmp_ps(v, rhs.v, _CMP_NEQ_UQ); }
+
+    static inline Float8 Min(const Float8 &f, const Float8 &s) { return _mm256_min_ps(s.v, f.v); }
+    static inline Float8 Max(const Float8 &f, const Float8 &s) { return _mm256_max_ps(f.v, s.v); }
+    static inline Float8 Sqrt(const Float8 &value) { return _mm256_sqrt_ps(value.v); }
+    static inline Float8 Abs(const Float8 &value) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), value.v); }
+
+    static inline Float8 Select(const Mask8 &mask, const Float8 &ifTrue, const Float8 &ifFalse)
+    {
+        return _mm256_blendv_ps(ifFalse.v, ifTrue.v, mask.v);
+    }
+
+    __m256 v;
+#else
+    Float8()
+    {
+
+    }
+
+    Float8(const Float4 &low, const Float4 &high) : lo(low), hi(high)
+    {
+
+    }
+
+    Float8(float value) : lo(value), hi(value)
+    {
+
+    }
+
+    static inline Float8 Load(const float *values) { return Float8(Float4::Load(values), Float4::Load(values + 4)); }
+    inline void Store(float *values) const { lo.Store(values); hi.Store(values + 4); }
+
+    inline Float8 operator-() const { return Float8(-lo, -hi); }
+    inline Float8 operator+(const Float8 &rhs) const { return Float8(lo + rhs.lo, hi + rhs.hi); }
+    inline Float8 operator-(const Float8 &rhs) const { return Float8(lo - rhs.lo, hi - rhs.hi); }
+    inline Float8 operator*(const Float8 &rhs) const { return Float8(lo * rhs.lo, hi * rhs.hi); }
+    inline Float8 operator/(const Float8 &rhs) const { return Float8(lo / rhs.lo, hi / rhs.hi); }
+
+    inline Mask8 operator<(const Float8 &rhs) const { return Mask8(lo < rhs.lo, hi < rhs.hi); }
+    inline Mask8 operator<=(const Float8 &rhs) const { return Mask8(lo <= rhs.lo, hi <= rhs.hi); }
+    inline Mask8 operator>(const Float8 &rhs) const { return Mask8(lo > rhs.lo, hi > rhs.hi); }
+    inline Mask8 operator>=(const Float8 &rhs) const { return Mask8(lo >= rhs.lo, hi >= rhs.hi); }
+    inline Mask8 operator==(const Float8 &rhs) const { return Mask8(lo == rhs.lo, hi == rhs.hi); }
+    inline Mask8 operator!=(const Float8 &rhs) const { return Mask8(lo != rhs.lo, hi != rhs.hi); }
+
+    static inline Float8 Min(const Float8 &f, const Float8 &s) { return Float8(Float4::Min(f.lo, s.lo), Float4::Min(f.hi, s.hi)); }
+    static inline Float8 Max(const Float8 &f, const Float8 &s) { return Float8(Float4::Max(f.lo, s.lo), Float4::Max(f.hi, s.hi)); }
+    static inline Float8 Sqrt(const Float8 &value) { return Float8(Float4::Sqrt(value.lo), Float4::Sqrt(value.hi)); }
+    static inline Float8 Abs(const Float8 &value) { return Float8(Float4::Abs(value.lo), Float4::Abs(value.hi)); }
+
+    static inline Float8 Select(const Mask8 &mask, const Float8 &ifTrue, const Float8 &ifFalse)
+    {
+        return Float8(Float4::Select(mask.lo, ifTrue.lo, ifFalse.lo), Float4::Select(mask.hi, ifTrue.hi, ifFalse.hi));
+    }
+
+    // Lanes 0-3 and 4-7
+    Float4 lo, hi;
+#endif
+
+    inline float operator[](int index) const { float values[8]; Store(values); return values[index]; }
+
+    inline void operator+=(const Float8 &rhs) { *this = *this + rhs; }
+    inline void operator-=(const Float8 &rhs) { *this = *this - rhs; }
+    inline void operator*=(const Float8 &rhs) { *this = *this * rhs; }
+    inline void operator/=(const Float8 &rhs) { *this = *this / rhs; }
+};
+
+/*
+    Packet of Float::Width vectors stored as one packet per component
+*/
+template <typename Float>
+struct Vector3xN
+{
+    typedef typename Float::Mask Mask;
+
+    static const int Width = Float::Width;
+
+    Vector3xN()
+    {
+
+    }
+
+    Vector3xN(const Float &vx, const Float &vy, const Float &vz) : x(vx), y(vy), z(vz)
+    {
+
+    }
+
+    // Same vector in every lane
+    Vector3xN(const Vector3 &value) : x(value.x), y(value.y), z(value.z)
+    {
+
+    }
+
+    // Loads Width consecutive vectors from structure of arrays component storage
+    static inline Vector3xN Load(const float *xs, const float *ys, const float *zs)
+    {
+        return Vector3xN(Float::Load(xs), Float::Load(ys), Float::Load(zs));
+    }
+
+    inline void Store(float *xs, float *ys, float *zs) const
+    {
+        x.Store(xs);
+        y.Store(ys);
+        z.Store(zs);
+    }
+
+    inline Vector3 GetLane(int index) const
+    {
+        return Vector3(x[index], y[index], z[index]);
+    }
+
+    static inline Float Dot(const Vector3xN &v1, const Vector3xN &v2)
+    {
+        return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+    }
+
+    static inline Vector3xN Cross(const Vector3xN &v1, const Vector3xN &v2)
+    {
+        return Vector3xN(v1.y * v2.z - v1.z * v2.y,
+                         v1.z * v2.x - v1.x * v2.z,
+                         v1.x * v2.y - v1.y * v2.x);
+    }
+
+    inline Float Length() const
+    {
+        return Float::Sqrt(x * x + y * y + z * z);
+    }
+
+    inline Vector3xN GetNormalized() const
+    {
+        return *this / Length();
+    }
+
+    static inline Vector3xN Select(const Mask &mask, const Vector3xN &ifTrue, const Vector3xN &ifFalse)
+    {
+        return Vector3xN(Float::Select(mask, ifTrue.x, ifFalse.x), Float::Select(mask, ifTrue.y, ifFalse.y), Float::Select(mask, ifTrue.z, ifFalse.z));
+    }
+
+    inline Vector3xN operator-() const { return Vector3xN(-x, -y, -z); }
+    inline Vector3xN operator+(const Vector3xN &rhs) const { return Vector3xN(x + rhs.x, y + rhs.y, z + rhs.z); }
+    inline Vector3xN operator-(const Vector3xN &rhs) const { return Vector3xN(x - rhs.x, y - rhs.y, z - rhs.z); }
+    inline Vector3xN operator*(const Vector3xN &rhs) const { return Vector3xN(x * rhs.x, y * rhs.y, z * rhs.z); }
+    inline Vector3xN operator*(const Float &rhs) const { return Vector3xN(x * rhs, y * rhs, z * rhs); }
+    inline Vector3xN operator/(const Float &rhs) const { return Vector3xN(x / rhs, y / rhs, z / rhs); }
+
+    inline void operator+=(const Vector3xN &rhs) { x += rhs.x; y += rhs.y; z += rhs.z; }
+
+    Float x, y, z;
+};
+
+typedef Vector3xN<Float4> Vector3x4;
+typedef Vector3xN<Float8> Vector3x8;
+
+#endif
@@ -0,0 +1,138 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#include "Sampler.h"
+
+static const uint32_t primes[HALTON_MAX_DIMENSION] =
+{
+    2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+    59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131
+};
+
+static const HaltonSampler haltonSampler;
+static const SobolSampler sobolSampler;
+
+// Integer hash (lowbias32), used to derive seeds and random offsets
+static inline uint32_t HashBits(uint32_t value)
+{
+    value ^= value >> 16;
+    value *= 0x7feb352du;
+    value ^= value >> 15;
+    value *= 0x846ca68bu;
+    value ^= value >> 16;
+    return value;
+}
+
+static inline uint32_t HashCombine(uint32_t seed, uint32_t value)
+{
+    return HashBits(seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+}
+
+// Uniform float in [0, 1) from the upper 24 bits
+static inline float BitsToFloat(uint32_t bits)
+{
+    return (bits >> 8) * (1.f / 16777216.f);
+}
+
+static inline uint32_t ReverseBits(uint32_t value)
+{
+    value = ((value >> 1) & 0x55555555u) | ((value & 0x55555555u) << 1);
+    value = ((value >> 2) & 0x33333333u) | ((value & 0x33333333u) << 2);
+    value = ((value >> 4) & 0x0f0f0f0fu) | ((value & 0x0f0f0f0fu) << 4);
+    value = ((value >> 8) & 0x00ff00ffu) | ((value & 0x00ff00ffu) << 8);
+    return (value >> 16) | (value << 16);
+}
+
+// Hash based Owen scrambling (Laine-Karras permutation on the reversed bits)
+// Every bit is flipped depending on the bits above it only, so stratification is kept
+static inline uint32_t NestedUniformScramble(uint32_t value, uint32_t seed)
+{
+    value = ReverseBits(value);
+
+    value += seed;
+    value ^= value * 0x6c50b47cu;
+    value ^= value * 0xb82f1e52u;
+    value ^= value * 0xc7afe638u;
+    value ^= value * 0x8d22f6e6u;
+
+    return ReverseBits(value);
+}
+
+// First two Sobol dimensions, the first one is the van der Corput sequence
+static inline uint32_t Sobol2D(uint32_t index, uint32_t dimension)
+{
+    if(dimension == 0)
+    {
+        return ReverseBits(index);
+    }
+
+    uint32_t result = 0;
+    uint32_t direction = 1u << 31;
+
+    for(; index != 0; index >>= 1)
+    {
+        if(index & 1)
+        {
+            result ^= direction;
+        }
+
+        direction ^= direction >> 1;
+    }
+
+    return result;
+}
+
+const Sampler *Sampler::GetSampler(SAMPLER_TYPE type)
+{
+    switch(type)
+    {
+        case SAMPLER_TYPE::HALTON:
+            return &haltonSampler;
+        case SAMPLER_TYPE::SOBOL:
+            return &sobolSampler;
+        default:
+            return nullptr;
+    }
+}
+
+float HaltonSampler::GetSample(uint32_t pixelSeed, uint32_t sampleIndex, uint32_t dimension) const
+{
+    uint32_t offsetBits = HashCombine(pixelSeed, dimension);
+
+    if(dimension >= HALTON_MAX_DIMENSION)
+    {
+        return BitsToFloat(HashCombine(offsetBits, sampleIndex));
+    }
+
+    // Radical inverse of the sample index in the dimension's base
+    uint32_t base = primes[dimension];
+    float inverseBase = 1.f / base;
+    float digitWeight = inverseBase;
+    float value = 0.f;
+
+    for(uint32_t index = sampleIndex; index > 0; index /= base)
+    {
+        value += (index % base) * digitWeight;
+        digitWeight *= inverseBase;
+    }
+
+    // Random shift of the pixel, wrapped around
+    value += BitsToFloat(offsetBits);
+    if(value >= 1.f) value -= 1.f;
+
+    // Rounding may land exactly on 1
+    return value < 1.f ? value : 1.f - 1.f / 16777216.f;
+}
+
+float SobolSampler::GetSample(uint32_t pixelSeed, uint32_t sampleIndex, uint32_t dimension) const
+{
+    uint32_t pairSeed = HashCombine(pixelSeed, dimension >> 1);
+
+    uint32_t shuffledIndex = NestedUniformScramble(sampleIndex, pairSeed);
+    uint32_t value = Sobol2D(shuffledIndex, dimension & 1);
+
+    return BitsToFloat(NestedUniformScramble(value, HashCombine(pairSeed, dimension)));
+}
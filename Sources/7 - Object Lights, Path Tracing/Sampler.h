@@ -0,0 +1,67 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#ifndef __SAMPLER_H__
+#define __SAMPLER_H__
+
+#include <cstdint>
+
+enum class SAMPLER_TYPE : uint8_t
+{
+    INDEPENDENT = 0,
+    HALTON,
+    SOBOL
+};
+
+// Dimensions of the camera decisions, the path decisions take the following ones in the order they are made
+#define SAMPLE_PIXEL_DIMENSION 0
+#define SAMPLE_LENS_DIMENSION 2
+#define SAMPLE_FIRST_PATH_DIMENSION 4
+
+// Halton dimensions beyond this use hashed random numbers
+#define HALTON_MAX_DIMENSION 32
+
+/*
+    Sample generator interface
+    Returns the value of a dimension of a pixel's sample point in [0, 1)
+    Samplers are stateless, pixelSeed decorrelates the points of the pixels
+*/
+class Sampler
+{
+public:
+    virtual ~Sampler()
+    {
+
+    }
+
+    virtual float GetSample(uint32_t pixelSeed, uint32_t sampleIndex, uint32_t dimension) const = 0;
+
+    // Returns the sampler of the type, nullptr for independent sampling
+    static const Sampler *GetSampler(SAMPLER_TYPE type);
+};
+
+/*
+    Halton sequence with a prime base per dimension
+    Every pixel shifts the dimensions by a random offset of its own
+*/
+class HaltonSampler : public Sampler
+{
+public:
+    float GetSample(uint32_t pixelSeed, uint32_t sampleIndex, uint32_t dimension) const override;
+};
+
+/*
+    Owen scrambled Sobol sequence (Burley 2020)
+    Dimensions are handed out in pairs of the first two Sobol dimensions, every pair and every pixel
+    shuffles the sample order and scrambles the values differently, so there is no dimension limit
+*/
+class SobolSampler : public Sampler
+{
+public:
+    float GetSample(uint32_t pixelSeed, uint32_t sampleIndex, uint32_t dimension) const override;
+};
+
+#endif
@@ -6,10 +6,14 @@
 
 #include "Scene.h"
 
+#include <bitset>
 #include <iostream>
 
+#include "Mesh.h"
 #include "ObjectBase.h"
+#include "ProgressReporter.h"
 #include "SceneParser.h"
+#include "ThreadPool.h"
 
 #include "LightMesh.h"
 #include "LightSphere.h"
@@ -22,8 +26,6 @@ Scene::Scene()
     useBVH = true;
 
     ambientLight = Vector3::ZeroVector;
-
-    pathTracingBounceCount = 1;
 }
 
 Scene::~Scene()
@@ -47,9 +49,27 @@ Scene::~Scene()
 
 void Scene::CreateBVH()
 {
+    // Instances copy their base mesh's hierarchy, so they are handled after every other object is built
+    std::vector<ObjectBase *> instances;
+    std::vector<ObjectBase *> baseObjects;
+
     for(auto object : objects)
     {
-        object->CreateBVH();
+        if(dynamic_cast<MeshInstance *>(object)) instances.push_back(object);
+        else baseObjects.push_back(object);
+    }
+
+    ThreadPool::ParallelFor(baseObjects.size(), 1, [&](size_t begin, size_t end)
+    {
+        for(size_t objectIndex = begin; objectIndex < end; objectIndex++)
+        {
+            baseObjects[objectIndex]->CreateBVH();
+        }
+    });
+
+    for(auto instance : instances)
+    {
+        instance->CreateBVH();
     }
 }
 
@@ -60,6 +80,8 @@ void Scene::ReadSceneData(char *filePath)
 
 bool Scene::SingleRayTrace(const Ray &ray, float &hitT, Vector3 &hitN, float &beta, float &gamma, const ObjectBase **hitObject, bool shadowCheck) const
 {
+    ProgressReporter::AddRays(1);
+
     if(useBVH)
     {
         return SingleRayTraceBVH(ray, hitT, hitN, beta, gamma, hitObject, shadowCheck);
@@ -75,6 +97,9 @@ bool Scene::SingleRayTraceBVH(const Ray &ray, float &hitT, Vector3 &hitN, float
     if(hitObject != nullptr) *hitObject = nullptr;
     hitT = 0;
 
+    // End of the interval the next object is searched in, the caller's ray is left as it is
+    float closestT = ray.tMax;
+
     for(auto object : objects)
     {
         float t = 0.f, b = 0.f, g = 0.f;
@@ -84,7 +109,10 @@ bool Scene::SingleRayTraceBVH(const Ray &ray, float &hitT, Vector3 &hitN, float
         Vector3 transformatedE = Vector3(object->inverseTransformationMatrix * Vector4(ray.e, 1.f));
         Vector3 transformatedDir = Vector3(object->inverseTransformationMatrix * Vector4(ray.dir, 0.f));
 
-        if(object->bvh.Intersection(Ray(transformatedE, transformatedDir), t, n, b, g, &obj, shadowCheck))
+        // Objects after a hit only have to find closer hits
+        Ray objectRay(transformatedE, transformatedDir, ray.tMin, closestT);
+
+        if(object->bvh.Intersection(objectRay, t, n, b, g, &obj, shadowCheck))
         {
             if ((hitT > 0 && hitT > t) || hitT <= 0)
             {
@@ -93,6 +121,8 @@ bool Scene::SingleRayTraceBVH(const Ray &ray, float &hitT, Vector3 &hitN, float
                 beta = b;
                 gamma = g;
                 *hitObject = obj;
+
+                closestT = t;
             }
         }
     }
@@ -100,6 +130,70 @@ bool Scene::SingleRayTraceBVH(const Ray &ray, float &hitT, Vector3 &hitN, float
     return hitT > 0 ? true : false;
 }
 
+bool Scene::OcclusionTrace(const Ray &ray) const
+{
+    ProgressReporter::AddRays(1);
+
+    for(auto object : objects)
+    {
+        if(!object->castsShadows)
+        {
+            continue;
+        }
+
+        Vector3 transformatedE = Vector3(object->inverseTransformationMatrix * Vector4(ray.e, 1.f));
+        Vector3 transformatedDir = Vector3(object->inverseTransformationMatrix * Vector4(ray.dir, 0.f));
+
+        // Transformations are affine, so the ray parameter and its interval stay the same in the object space
+        Ray objectRay(transformatedE, transformatedDir, ray.tMin, ray.tMax);
+
+        if(useBVH ? object->bvh.OcclusionIntersection(objectRay) : object->OcclusionIntersection(objectRay))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+Mask8 Scene::OcclusionTrace(const RayPacket8 &packet, const Mask8 &active) const
+{
+    ProgressReporter::AddRays(std::bitset<RayPacket8::Width>(active.GetBits()).count());
+
+    Mask8 occluded = Mask8::FromBits(0);
+
+    for(auto object : objects)
+    {
+        if(!object->castsShadows)
+        {
+            continue;
+        }
+
+        Mask8 remaining = active & !occluded;
+
+        if(remaining.None())
+        {
+            break;
+        }
+
+        RayPacket8 objectPacket(object->inverseTransformationMatrix.TransformPoint(packet.e), object->inverseTransformationMatrix.TransformDirection(packet.dir), packet.tMin, packet.tMax);
+
+        occluded = occluded | (useBVH ? object->bvh.OcclusionIntersection(objectPacket, remaining) : object->OcclusionIntersection(objectPacket, remaining));
+    }
+
+    return occluded;
+}
+
+int Scene::OcclusionTrace(const Ray *rays, int rayCount) const
+{
+    if(rayCount == 1)
+    {
+        return OcclusionTrace(rays[0]) ? 1 : 0;
+    }
+
+    return OcclusionTrace(RayPacket8::Load(rays, rayCount), Mask8::FromBits((1 << rayCount) - 1)).GetBits();
+}
+
 bool Scene::SingleRayTraceNonBVH(const Ray &ray, float &hitT, Vector3 &hitN, float &beta, float &gamma, const ObjectBase **hitObject, bool shadowCheck) const
 {
     unsigned int objectCount = objects.size();
@@ -107,22 +201,31 @@ bool Scene::SingleRayTraceNonBVH(const Ray &ray, float &hitT, Vector3 &hitN, flo
     if(hitObject != nullptr) *hitObject = nullptr;
     hitT = 0;
 
+    // End of the interval the next object is searched in, the caller's ray is left as it is
+    float closestT = ray.tMax;
+
     for (size_t objectIndex = 0; objectIndex < objectCount; objectIndex++)
 	{
 		ObjectBase *currentObject = objects[objectIndex];
 		
-        float t;
+        float t, b, g;
         Vector3 n;
+        const ObjectBase *obj = nullptr;
 
         Vector3 transformatedE = Vector3(currentObject->inverseTransformationMatrix * Vector4(ray.e, 1.f));
         Vector3 transformatedDir = Vector3(currentObject->inverseTransformationMatrix * Vector4(ray.dir, 0.f));
 
-		if (currentObject->Intersection(Ray(transformatedE, transformatedDir), t, n, beta, gamma, hitObject, shadowCheck))
+		if (currentObject->Intersection(Ray(transformatedE, transformatedDir, ray.tMin, closestT), t, n, b, g, &obj, shadowCheck))
 		{
 			if ((hitT > 0 && hitT > t) || hitT <= 0)
 			{
                 hitT = t;
                 hitN = n;
+                beta = b;
+                gamma = g;
+                if(hitObject != nullptr) *hitObject = obj;
+
+                closestT = t;
 			}
 		}
 	}
@@ -15,8 +15,18 @@
 #include "Material.h"
 #include "Math.h"
 #include "Light.h"
+#include "LightBVH.h"
+#include "ProgressReporter.h"
 #include "Ray.h"
+#include "Sampler.h"
 #include "Texture.h"
+#include "TileScheduler.h"
+
+// Bounces every path takes before Russian roulette may end it
+#define DEFAULT_RUSSIAN_ROULETTE_MIN_DEPTH 3
+
+// Keeps bright paths from surviving for sure, so they end eventually too
+#define DEFAULT_MAX_SURVIVAL_PROBABILITY 0.95f
 
 class BRDF;
 class ObjectBase;
@@ -25,7 +35,8 @@ class Texture;
 enum class INTEGRATOR : uint8_t
 {
     RAY_TRACER = 0,
-    PATH_TRACER
+    PATH_TRACER,
+    WAVEFRONT_PATH_TRACER
 };
 
 enum class INTEGRATOR_PARAMS : uint8_t
@@ -55,6 +66,18 @@ public:
 
     bool SingleRayTraceBVH(const Ray &ray, float &hitT, Vector3 &hitN, float &beta, float &gamma, const ObjectBase **hitObject = nullptr, bool shadowCheck = false) const;
     bool SingleRayTraceNonBVH(const Ray &ray, float &hitT, Vector3 &hitN, float &beta, float &gamma, const ObjectBase **hitObject = nullptr, bool shadowCheck = false) const;
+
+    // Occlusion kernel of the shadow rays
+    // Returns true as soon as any shadow casting object is hit within the ray's interval
+    bool OcclusionTrace(const Ray &ray) const;
+
+    // Packet version, returns the active lanes that are occluded
+    // Occluded lanes are not traced against the remaining objects
+    Mask8 OcclusionTrace(const RayPacket8 &packet, const Mask8 &active) const;
+
+    // Traces up to RayPacket8::Width rays and returns the bits of the occluded ones
+    // A single ray is traced alone, a packet of one lane costs more than the ray
+    int OcclusionTrace(const Ray *rays, int rayCount) const;
     
     std::vector<Camera> cameras;
     std::vector<Light *> lights;
@@ -76,12 +99,36 @@ public:
     
     unsigned int maxRecursionDepth;
 
-    unsigned int pathTracingBounceCount;
-
     INTEGRATOR integrator;
     INTEGRATOR_PARAMS integratorParams;
 
+    // Path tracers end paths past the minimum depth at random, the survival probability follows the throughput
+    bool russianRoulette = false;
+    unsigned int russianRouletteMinDepth = DEFAULT_RUSSIAN_ROULETTE_MIN_DEPTH;
+    float maxSurvivalProbability = DEFAULT_MAX_SURVIVAL_PROBABILITY;
+
     bool useBVH = true;
+
+    // Shading points pick lightBVHSampleCount lights from the light BVH instead of shading with every light
+    bool useLightBVH = false;
+    unsigned int lightBVHSampleCount = DEFAULT_LIGHT_BVH_SAMPLE_COUNT;
+    LightBVH lightBVH;
+
+    // Wavefront integrator traces the secondary rays ordered by direction octant and origin cell
+    bool sortSecondaryRays = false;
+
+    // Edge length of the image tiles in pixels and the order the tiles are dealt out in
+    unsigned int tileSize = DEFAULT_TILE_SIZE;
+    TILE_ORDER tileOrder = TILE_ORDER::HILBERT;
+
+    // Source of the sample dimensions, low discrepancy samplers need fewer samples for the same noise
+    SAMPLER_TYPE samplerType = SAMPLER_TYPE::INDEPENDENT;
+
+    // Render thread count of the scene, 0 uses the hardware thread count
+    unsigned int threadCount = 0;
+
+    // Seconds between the progress reports, 0 only prints the summary
+    float progressInterval = DEFAULT_PROGRESS_INTERVAL;
 };
 
 // Global scene variable
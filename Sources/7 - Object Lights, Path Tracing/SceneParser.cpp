@@ -30,6 +30,10 @@
 #include "SpotLight.h"
 
 #include "BoundingVolume.h"
+#include "ThreadPool.h"
+
+// Vertices per vertex normal normalization chunk
+#define VERTEX_NORMAL_GRAIN_SIZE 16384
 
 using tinyxml2::XMLDocument;
 
@@ -50,6 +54,9 @@ void SceneParser::Parse(Scene *scene, char *filePath)
         throw std::runtime_error("Error: Root could not be found.");
     }
 
+    // Texture images are decoded on the thread pool while the rest of the scene is parsed
+    TaskGroup textureLoadingTasks;
+
     auto element = root->FirstChildElement("IntersectionTestEpsilon");
     if (element)
     {
@@ -108,6 +115,10 @@ void SceneParser::Parse(Scene *scene, char *filePath)
         {
             scene->integrator = INTEGRATOR::PATH_TRACER;
         }
+        else if(integrator == "WavefrontPathTracing")
+        {
+            scene->integrator = INTEGRATOR::WAVEFRONT_PATH_TRACER;
+        }
         else
         {
             scene->integrator = INTEGRATOR::RAY_TRACER;
@@ -139,6 +150,98 @@ void SceneParser::Parse(Scene *scene, char *filePath)
         scene->integratorParams = INTEGRATOR_PARAMS::UNIFORM_SAMPLING;
     }
 
+    element = root->FirstChildElement("RussianRoulette");
+    if(element)
+    {
+        scene->russianRoulette = true;
+
+        auto child = element->FirstChildElement("MinDepth");
+        if(child)
+        {
+            stream << child->GetText() << std::endl;
+            stream >> scene->russianRouletteMinDepth;
+        }
+
+        child = element->FirstChildElement("MaxSurvivalProbability");
+        if(child)
+        {
+            stream << child->GetText() << std::endl;
+            stream >> scene->maxSurvivalProbability;
+        }
+    }
+
+    element = root->FirstChildElement("LightBVH");
+    if(element)
+    {
+        scene->useLightBVH = true;
+
+        auto child = element->FirstChildElement("SampleCount");
+        if(child)
+        {
+            stream << child->GetText() << std::endl;
+            stream >> scene->lightBVHSampleCount;
+        }
+    }
+
+    element = root->FirstChildElement("ThreadCount");
+    if(element)
+    {
+        stream << element->GetText() << std::endl;
+        stream >> scene->threadCount;
+    }
+
+    element = root->FirstChildElement("ProgressInterval");
+    if(element)
+    {
+        stream << element->GetText() << std::endl;
+        stream >> scene->progressInterval;
+    }
+
+    element = root->FirstChildElement("TileSize");
+    if(element)
+    {
+        stream << element->GetText() << std::endl;
+        stream >> scene->tileSize;
+    }
+
+    element = root->FirstChildElement("TileOrder");
+    if(element)
+    {
+        stream << element->GetText() << std::endl;
+        std::string tileOrder;
+        stream >> tileOrder;
+
+        if(tileOrder == "Spiral")
+        {
+            scene->tileOrder = TILE_ORDER::SPIRAL;
+        }
+        else
+        {
+            scene->tileOrder = TILE_ORDER::HILBERT;
+        }
+    }
+
+    element = root->FirstChildElement("Sampler");
+    if(element)
+    {
+        stream << element->GetText() << std::endl;
+        std::string samplerType;
+        stream >> samplerType;
+
+        if(samplerType == "Halton")
+        {
+            scene->samplerType = SAMPLER_TYPE::HALTON;
+        }
+        else if(samplerType == "Sobol")
+        {
+            scene->samplerType = SAMPLER_TYPE::SOBOL;
+        }
+        else
+        {
+            scene->samplerType = SAMPLER_TYPE::INDEPENDENT;
+        }
+    }
+
     //Get Cameras
     element = root->FirstChildElement("Cameras");
     element = element->FirstChildElement("Camera");
@@ -258,6 +361,98 @@ void SceneParser::Parse(Scene *scene, char *filePath)
         }
         stream >> camera.numberOfSamples;
 
+        child = element->FirstChildElement("Filter");
+        camera.useFilter = child != nullptr;
+        camera.filterType = FILTER_TYPE::GAUSSIAN;
+        camera.filterMode = FILTER_MODE::WEIGHTED;
+        camera.filterRadius = DEFAULT_FILTER_RADIUS;
+
+        if(child)
+        {
+            const char *filterType = child->Attribute("type");
+
+            if(filterType && std::string(filterType) == "Box")
+            {
+                camera.filterType = FILTER_TYPE::BOX;
+            }
+            else if(filterType && std::string(filterType) == "Tent")
+            {
+                camera.filterType = FILTER_TYPE::TENT;
+            }
+            else if(filterType && std::string(filterType) == "Mitchell")
+            {
+                camera.filterType = FILTER_TYPE::MITCHELL;
+            }
+
+            auto subChild = child->FirstChildElement("Radius");
+            if(subChild)
+            {
+                stream << subChild->GetText() << std::endl;
+                stream >> camera.filterRadius;
+            }
+
+            subChild = child->FirstChildElement("Mode");
+            if(subChild)
+            {
+                std::string filterMode;
+                stream << subChild->GetText() << std::endl;
+                stream >> filterMode;
+
+                if(filterMode == "Splat")
+                {
+                    camera.filterMode = FILTER_MODE::SPLAT;
+                }
+                else if(filterMode == "Importance")
+                {
+                    camera.filterMode = FILTER_MODE::IMPORTANCE;
+                }
+            }
+        }
+
+        child = element->FirstChildElement("Progressive");
+        camera.progressive = child != nullptr;
+        camera.timeBudget = 0.f;
+        camera.outputInterval = 0.f;
+
+        if(child)
+        {
+            auto subChild = child->FirstChildElement("TimeBudget");
+            if(subChild)
+            {
+                stream << subChild->GetText() << std::endl;
+                stream >> camera.timeBudget;
+            }
+
+            subChild = child->FirstChildElement("OutputInterval");
+            if(subChild)
+            {
+                stream << subChild->GetText() << std::endl;
+                stream >> camera.outputInterval;
+            }
+        }
+
+        child = element->FirstChildElement("AdaptiveSampling");
+        camera.adaptiveSampling = child != nullptr;
+        camera.minSamples = ADAPTIVE_DEFAULT_MIN_SAMPLES;
+        camera.noiseThreshold = ADAPTIVE_DEFAULT_NOISE_THRESHOLD;
+
+        if(child)
+        {
+            auto subChild = child->FirstChildElement("MinSamples");
+            if(subChild)
+            {
+                stream << subChild->GetText() << std::endl;
+                stream >> camera.minSamples;
+            }
+
+            subChild = child->FirstChildElement("NoiseThreshold");
+            if(subChild)
+            {
+                stream << subChild->GetText() << std::endl;
+                stream >> camera.noiseThreshold;
+            }
+        }
+
         child = element->FirstChildElement("ImageName");
         stream << child->GetText() << std::endl;
         stream >> camera.imageName;
@@ -371,6 +566,13 @@ void SceneParser::Parse(Scene *scene, char *filePath)
             stream << child->GetText() << std::endl;
             stream >> areaLight->edgeVectorV.x >> areaLight->edgeVectorV.y >> areaLight->edgeVectorV.z;
 
+            child = element->FirstChildElement("NumSamples");
+            if(child)
+            {
+                stream << child->GetText() << std::endl;
+                stream >> areaLight->sampleCount;
+            }
+
             areaLight->lightNormal = Vector3::Cross(areaLight->edgeVectorV, areaLight->edgeVectorU);
             areaLight->lightNormal.Normalize();
 
@@ -528,11 +730,11 @@ void SceneParser::Parse(Scene *scene, char *filePath)
         {
             TorranceSparrow *torranceSparrow = new TorranceSparrow();
 
-            auto child = element->FirstChildElement("Exponent");
+            auto child = sibling->FirstChildElement("Exponent");
             stream << child->GetText() << std::endl;
             stream >> torranceSparrow->exponent;
 
-            child = element->FirstChildElement("RefractiveIndex");
+            child = sibling->FirstChildElement("RefractiveIndex");
             stream << child->GetText() << std::endl;
             stream >> torranceSparrow->refractiveIndex;
 
@@ -749,12 +951,15 @@ void SceneParser::Parse(Scene *scene, char *filePath)
             
             if(texture->imagePath != "perlin")
             {
-                bool textureLoaded = texture->LoadTextureImage();
-
-                if(!textureLoaded)
+                textureLoadingTasks.Run([texture]
                 {
-                    std::cerr << "Texture is failed to load." << std::endl;
-                }
+                    bool textureLoaded = texture->LoadTextureImage();
+
+                    if(!textureLoaded)
+                    {
+                        std::cerr << "Texture is failed to load." << std::endl;
+                    }
+                });
             }
 
             scene->textures.push_back(texture);
@@ -1157,14 +1362,17 @@ void SceneParser::Parse(Scene *scene, char *filePath)
     }
     stream.clear();
 
-    for(unsigned int normalIndex = 0; normalIndex < scene->vertices.size(); normalIndex++)
+    ThreadPool::ParallelFor(scene->vertices.size(), VERTEX_NORMAL_GRAIN_SIZE, [&](size_t begin, size_t end)
     {
-        if(vertexNormalDivider[normalIndex] != 0)
+        for(size_t normalIndex = begin; normalIndex < end; normalIndex++)
         {
-            scene->vertexNormals[normalIndex] /= vertexNormalDivider[normalIndex];
-            scene->vertexNormals[normalIndex].Normalize();
+            if(vertexNormalDivider[normalIndex] != 0)
+            {
+                scene->vertexNormals[normalIndex] /= vertexNormalDivider[normalIndex];
+                scene->vertexNormals[normalIndex].Normalize();
+            }
         }
-    }
+    });
 
     delete[] vertexNormalDivider;
 
@@ -1185,6 +1393,13 @@ void SceneParser::Parse(Scene *scene, char *filePath)
         child = element->FirstChildElement("Radiance");
         stream << child->GetText() << std::endl;
         stream >> lightMesh->intensity.x >> lightMesh->intensity.y >> lightMesh->intensity.z;
+
+        child = element->FirstChildElement("NumSamples");
+        if(child)
+        {
+            stream << child->GetText() << std::endl;
+            stream >> lightMesh->sampleCount;
+        }
  
         child = element->FirstChildElement("Transformations");
         if(child)
@@ -1254,6 +1469,8 @@ void SceneParser::Parse(Scene *scene, char *filePath)
         }
         stream.clear();
 
+        lightMesh->PrepareSampling();
+
         scene->lights.push_back(lightMesh);
         scene->objects.push_back(lightMesh);
 
@@ -1489,6 +1706,14 @@ void SceneParser::Parse(Scene *scene, char *filePath)
         child = element->FirstChildElement("Radiance");
         stream << child->GetText() << std::endl;
         stream >> lightSphere->intensity.x >> lightSphere->intensity.y >> lightSphere->intensity.z;
+
+        child = element->FirstChildElement("NumSamples");
+        if(child)
+        {
+            stream << child->GetText() << std::endl;
+            stream >> lightSphere->sampleCount;
+        }
+
         stream.clear();
 
         child = element->FirstChildElement("Transformations");
@@ -1516,10 +1741,13 @@ void SceneParser::Parse(Scene *scene, char *filePath)
             }
         }
         lightSphere->SetInverseTransformationMatrix();
+        lightSphere->PrepareSampling();
         
         scene->lights.push_back(lightSphere);
         scene->objects.push_back(lightSphere);
         element = element->NextSiblingElement("LightSphere");
         stream.clear();
     }
+
+    textureLoadingTasks.Wait();
 }
\ No newline at end of file
@@ -0,0 +1,96 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#include "ShadowRayStream.h"
+
+#include "Light.h"
+#include "Scene.h"
+
+size_t ShadowRayStream::Add(unsigned int lightIndex, const Vector3 &lightPosition, const Vector3 &positionAt, float lightPdf)
+{
+    positionX.push_back(positionAt.x);
+    positionY.push_back(positionAt.y);
+    positionZ.push_back(positionAt.z);
+
+    lightPositionX.push_back(lightPosition.x);
+    lightPositionY.push_back(lightPosition.y);
+    lightPositionZ.push_back(lightPosition.z);
+
+    lightPdfs.push_back(lightPdf);
+    lightIndices.push_back(lightIndex);
+    occluded.push_back(0);
+
+    return lightIndices.size() - 1;
+}
+
+void ShadowRayStream::Trace(size_t first)
+{
+    size_t last = lightIndices.size();
+
+    if(first >= last)
+    {
+        return;
+    }
+
+    // Counting sort of the rays by their lights
+    size_t lightCount = mainScene->lights.size();
+    lightOffsets.assign(lightCount + 1, 0);
+
+    for(size_t rayIndex = first; rayIndex < last; rayIndex++)
+    {
+        lightOffsets[lightIndices[rayIndex] + 1]++;
+    }
+
+    for(size_t lightIndex = 0; lightIndex < lightCount; lightIndex++)
+    {
+        lightOffsets[lightIndex + 1] += lightOffsets[lightIndex];
+    }
+
+    order.resize(last - first);
+
+    for(size_t rayIndex = first; rayIndex < last; rayIndex++)
+    {
+        order[lightOffsets[lightIndices[rayIndex]]++] = rayIndex;
+    }
+
+    // Consecutive rays are traced together as packets, the rays of a packet mostly share their light
+    Ray rays[RayPacket8::Width];
+
+    for(size_t packetStart = 0; packetStart < order.size(); packetStart += RayPacket8::Width)
+    {
+        int rayCount = int(mathMin(order.size() - packetStart, size_t(RayPacket8::Width)));
+
+        for(int lane = 0; lane < rayCount; lane++)
+        {
+            size_t rayIndex = order[packetStart + lane];
+            const Light *light = mainScene->lights[lightIndices[rayIndex]];
+
+            rays[lane] = light->GetShadowRay(GetLightPosition(rayIndex), Vector3(positionX[rayIndex], positionY[rayIndex], positionZ[rayIndex]));
+        }
+
+        int occludedBits = mainScene->OcclusionTrace(rays, rayCount);
+
+        for(int lane = 0; lane < rayCount; lane++)
+        {
+            occluded[order[packetStart + lane]] = (occludedBits >> lane) & 1;
+        }
+    }
+}
+
+void ShadowRayStream::Truncate(size_t first)
+{
+    positionX.resize(first);
+    positionY.resize(first);
+    positionZ.resize(first);
+
+    lightPositionX.resize(first);
+    lightPositionY.resize(first);
+    lightPositionZ.resize(first);
+
+    lightPdfs.resize(first);
+    lightIndices.resize(first);
+    occluded.resize(first);
+}
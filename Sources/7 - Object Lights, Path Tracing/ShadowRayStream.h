@@ -0,0 +1,64 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#ifndef __SHADOWRAYSTREAM_H__
+#define __SHADOWRAYSTREAM_H__
+
+#include <vector>
+
+#include "Math.h"
+
+/*
+    Structure of arrays shadow ray stream
+    Shadow rays are queued while shading and traced together through the occlusion kernel
+    Nested shading calls use the stream like a stack, each one traces and truncates its own range
+*/
+class ShadowRayStream
+{
+public:
+    // Queues the shadow ray from positionAt towards the light sample, returns its index in the stream
+    // lightPdf is the solid angle density the sample was drawn with, 0 when it is not needed
+    size_t Add(unsigned int lightIndex, const Vector3 &lightPosition, const Vector3 &positionAt, float lightPdf = 0.f);
+
+    // Traces the rays queued after first, rays of the same light are traced one after another
+    void Trace(size_t first);
+
+    // Drops the rays queued after first
+    void Truncate(size_t first);
+
+    inline size_t GetSize() const
+    {
+        return lightIndices.size();
+    }
+
+    inline Vector3 GetLightPosition(size_t index) const
+    {
+        return Vector3(lightPositionX[index], lightPositionY[index], lightPositionZ[index]);
+    }
+
+    inline float GetLightPdf(size_t index) const
+    {
+        return lightPdfs[index];
+    }
+
+    inline bool IsOccluded(size_t index) const
+    {
+        return occluded[index] != 0;
+    }
+
+private:
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> lightPositionX, lightPositionY, lightPositionZ;
+    std::vector<float> lightPdfs;
+    std::vector<unsigned int> lightIndices;
+    std::vector<unsigned char> occluded;
+
+    // Trace order of the rays, grouped by light
+    std::vector<size_t> order;
+    std::vector<size_t> lightOffsets;
+};
+
+#endif
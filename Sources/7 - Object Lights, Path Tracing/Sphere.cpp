@@ -31,10 +31,14 @@ bool Sphere::Intersection(const Ray &ray, float &t, Vector3 &n, float &beta, flo
     t1 = minusBOverDen + sqrtBSquareMinusFourAcOverDen;
     t2 = minusBOverDen - sqrtBSquareMinusFourAcOverDen;
 
+    // Roots outside of the ray's interval do not count, NaN roots of a miss fail both tests
+    bool t1Valid = t1 > ray.tMin && t1 < ray.tMax;
+    bool t2Valid = t2 > ray.tMin && t2 < ray.tMax;
+
     bool isIntersecting = false;
     Vector3 intersectionPoint = Vector3::ZeroVector;
 
-    if (t1 > 0 && t2 > 0)
+    if (t1Valid && t2Valid)
     {
         t = t1 < t2 ? t1 : t2;
 
@@ -46,7 +50,7 @@ bool Sphere::Intersection(const Ray &ray, float &t, Vector3 &n, float &beta, flo
 
         isIntersecting = true;
     }
-    else if (t1 > 0)
+    else if (t1Valid)
     {
         t = t1;
 
@@ -58,7 +62,7 @@ bool Sphere::Intersection(const Ray &ray, float &t, Vector3 &n, float &beta, flo
 
         isIntersecting = true;
     }
-    else if (t2 > 0)
+    else if (t2Valid)
     {
         t = t2;
         intersectionPoint = ray.e + ray.dir * t;
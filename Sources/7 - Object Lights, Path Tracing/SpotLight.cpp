@@ -27,4 +27,14 @@ Vector3 SpotLight::GetIntensityAtPosition(const Vector3& lightPosition, const Ve
     //else
     float c = pow((cosTetha - cosCoverage) / (cosFalloff - cosCoverage), 4);
     return (intensity * c) / (intersectionDirectionLength * intersectionDirectionLength);
+}
+
+// Full intensity inside the falloff angle, fading out until the coverage angle
+bool SpotLight::GetBounds(LightBounds &bounds) const
+{
+    bounds = GetPointBounds(position, GetMaxIntensity());
+    bounds.axis = direction.GetNormalized();
+    bounds.cosThetaO = cosFalloff;
+    bounds.cosThetaE = cos(mathMax(0.f, coverageAngle - falloffAngle));
+    return true;
 }
\ No newline at end of file
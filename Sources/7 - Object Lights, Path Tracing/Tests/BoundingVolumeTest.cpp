@@ -0,0 +1,51 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+/*
+    Checks the box slab test against rays whose directions have zero components
+    Such rays have infinite inverse direction components, the slabs of those axes have to stay infinite instead of turning into NaNs
+*/
+
+#include <iostream>
+
+#include "../BoundingVolume.h"
+#include "../Ray.h"
+
+static bool Check(const char *name, bool result, bool expected)
+{
+    bool passed = result == expected;
+
+    std::cout << (passed ? "PASSED " : "FAILED ") << name << ": " << (result ? "hit" : "missed") << ", expected " << (expected ? "hit" : "miss") << std::endl;
+
+    return passed;
+}
+
+static bool TestAxisAlignedRays()
+{
+    BoundingVolume box(Vector3(1.f, 1.f, 1.f), Vector3(5.f, 5.f, 5.f));
+    box.left = nullptr;
+    box.right = nullptr;
+
+    bool passed = Check("Ray along +y", box.SlabTest(Ray(Vector3(3.f, 0.f, 3.f), Vector3(0.f, 1.f, 0.f))), true);
+    passed &= Check("Ray along -y", box.SlabTest(Ray(Vector3(3.f, 6.f, 3.f), Vector3(0.f, -1.f, 0.f))), true);
+    passed &= Check("Ray along +x", box.SlabTest(Ray(Vector3(0.f, 3.f, 3.f), Vector3(1.f, 0.f, 0.f))), true);
+    passed &= Check("Ray along -z", box.SlabTest(Ray(Vector3(3.f, 3.f, 6.f), Vector3(0.f, 0.f, -1.f))), true);
+    passed &= Check("Ray along +y starting inside", box.SlabTest(Ray(Vector3(3.f, 3.f, 3.f), Vector3(0.f, 1.f, 0.f))), true);
+    passed &= Check("Diagonal ray in the xy plane", box.SlabTest(Ray(Vector3(0.f, 0.f, 3.f), Vector3(1.f, 1.f, 0.f))), true);
+
+    passed &= Check("Ray along +y beside the box", box.SlabTest(Ray(Vector3(6.f, 0.f, 3.f), Vector3(0.f, 1.f, 0.f))), false);
+    passed &= Check("Ray along -y away from the box", box.SlabTest(Ray(Vector3(3.f, 0.f, 3.f), Vector3(0.f, -1.f, 0.f))), false);
+    passed &= Check("Ray along +y ending before the box", box.SlabTest(Ray(Vector3(3.f, 0.f, 3.f), Vector3(0.f, 1.f, 0.f), 0.f, 0.5f)), false);
+
+    return passed;
+}
+
+int main()
+{
+    bool passed = TestAxisAlignedRays();
+
+    return passed ? 0 : 1;
+}
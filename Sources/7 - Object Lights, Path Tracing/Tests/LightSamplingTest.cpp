@@ -0,0 +1,138 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+/*
+    Checks that light sampling covers the solid angle the emissive geometry takes up
+    Next-event estimation weights every sample with one over its density and drops the ones without a density,
+    so the mean of those weights is the solid angle of the light seen from the point
+*/
+
+#include <cmath>
+#include <iostream>
+
+#include "../LightMesh.h"
+#include "../LightSphere.h"
+#include "../RandomGenerator.h"
+#include "../Scene.h"
+#include "../Transformations.h"
+
+#define LIGHT_SAMPLING_TEST_SAMPLE_COUNT 1000000
+
+// Estimates failing by more than this relative error fail the test
+#define LIGHT_SAMPLING_TEST_TOLERANCE 0.01f
+
+static float EstimateSolidAngle(const Light &light, const Vector3 &positionAt)
+{
+    double sum = 0.0;
+
+    for(unsigned int sampleIndex = 0; sampleIndex < LIGHT_SAMPLING_TEST_SAMPLE_COUNT; sampleIndex++)
+    {
+        Vector3 lightNormal;
+        Vector3 lightPosition = light.SamplePosition(RandomGenerator::GetRandomFloat(), RandomGenerator::GetRandomFloat(), lightNormal);
+        float pdf = light.GetPdf(lightPosition, lightNormal, positionAt);
+
+        if(pdf > 0.f)
+        {
+            sum += 1.0 / pdf;
+        }
+    }
+
+    return float(sum / LIGHT_SAMPLING_TEST_SAMPLE_COUNT);
+}
+
+static bool Check(const char *name, float estimate, float expected)
+{
+    bool passed = std::fabs(estimate - expected) <= LIGHT_SAMPLING_TEST_TOLERANCE * expected;
+
+    std::cout << (passed ? "PASSED " : "FAILED ") << name << ": estimated " << estimate << ", expected " << expected << std::endl;
+
+    return passed;
+}
+
+// Solid angle of a sphere of the radius at the distance from its center
+static float GetSphereSolidAngle(float radius, float distance)
+{
+    return TWO_PI * (1.f - sqrt(1.f - radius * radius / (distance * distance)));
+}
+
+static bool TestLightSphere()
+{
+    LightSphere sphere;
+    sphere.center = Vector3::ZeroVector;
+    sphere.radius = 1.f;
+    sphere.PrepareSampling();
+
+    bool passed = Check("Unit light sphere", EstimateSolidAngle(sphere, Vector3(0.f, 0.f, 4.f)), GetSphereSolidAngle(1.f, 4.f));
+
+    LightSphere scaledSphere;
+    scaledSphere.center = Vector3::ZeroVector;
+    scaledSphere.radius = 1.f;
+    scaledSphere.SetTransformationMatrix(Transformation::GetScalingMatrix(Vector3(2.f)));
+    scaledSphere.SetInverseTransformationMatrix();
+    scaledSphere.PrepareSampling();
+
+    passed &= Check("Scaled light sphere", EstimateSolidAngle(scaledSphere, Vector3(0.f, 4.f, 0.f)), GetSphereSolidAngle(2.f, 4.f));
+
+    return passed;
+}
+
+// Closed unit cube seen from above the center of its top face, only that face is visible
+static bool TestClosedLightMesh()
+{
+    const Vector3 corners[8] = { Vector3(-1.f, -1.f, -1.f), Vector3(1.f, -1.f, -1.f), Vector3(1.f, 1.f, -1.f), Vector3(-1.f, 1.f, -1.f),
+                                 Vector3(-1.f, -1.f, 1.f), Vector3(1.f, -1.f, 1.f), Vector3(1.f, 1.f, 1.f), Vector3(-1.f, 1.f, 1.f) };
+
+    // Counter clockwise seen from outside
+    const unsigned int faceIndices[12][3] = { { 1, 3, 2 }, { 1, 4, 3 }, { 5, 6, 7 }, { 5, 7, 8 },
+                                              { 1, 2, 6 }, { 1, 6, 5 }, { 2, 3, 7 }, { 2, 7, 6 },
+                                              { 3, 4, 8 }, { 3, 8, 7 }, { 4, 1, 5 }, { 4, 5, 8 } };
+
+    mainScene->vertices.assign(corners, corners + 8);
+
+    LightMesh cube;
+
+    for(unsigned int faceIndex = 0; faceIndex < 12; faceIndex++)
+    {
+        Face *face = new Face();
+        face->v0 = faceIndices[faceIndex][0];
+        face->v1 = faceIndices[faceIndex][1];
+        face->v2 = faceIndices[faceIndex][2];
+
+        Vector3 a = mainScene->vertices[face->v0 - 1];
+        Vector3 b = mainScene->vertices[face->v1 - 1];
+        Vector3 c = mainScene->vertices[face->v2 - 1];
+
+        face->normal = Vector3::Cross(c - b, a - b);
+        Vector3::Normalize(face->normal);
+
+        cube.faces.push_back(face);
+    }
+
+    cube.PrepareSampling();
+
+    // Rectangle with the sides a and b seen from the distance d above its center
+    float a = 2.f, b = 2.f, d = 3.f;
+    float expected = 4.f * atan(a * b / (2.f * d * sqrt(4.f * d * d + a * a + b * b)));
+
+    bool passed = Check("Closed light mesh", EstimateSolidAngle(cube, Vector3(0.f, 0.f, 4.f)), expected);
+
+    for(Face *face : cube.faces)
+    {
+        delete face;
+    }
+
+    return passed;
+}
+
+int main()
+{
+    Scene scene;
+
+    bool passed = TestLightSphere();
+    passed &= TestClosedLightMesh();
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+/*
+    Checks that the SIMD packet paths give bit for bit the results of the scalar paths
+    Packet lanes are compared with the scalar results through their bits, so signed zeros and NaNs have to match too
+*/
+
+#include <cstring>
+#include <iostream>
+
+#include "../BoundingVolume.h"
+#include "../Matrix.h"
+#include "../Mesh.h"
+#include "../RandomGenerator.h"
+#include "../Ray.h"
+#include "../Scene.h"
+#include "../SIMD.h"
+#include "../Transformations.h"
+
+#define SIMD_TEST_ITERATION_COUNT 10000
+
+#define SIMD_TEST_TRIANGLE_COUNT 64
+
+static bool SameBits(float first, float second)
+{
+    return std::memcmp(&first, &second, sizeof(float)) == 0;
+}
+
+static bool SameBits(const Vector3 &first, const Vector3 &second)
+{
+    return SameBits(first.x, second.x) && SameBits(first.y, second.y) && SameBits(first.z, second.z);
+}
+
+static bool Check(const char *name, unsigned int mismatchCount)
+{
+    bool passed = mismatchCount == 0;
+
+    std::cout << (passed ? "PASSED " : "FAILED ") << name << ": " << mismatchCount << " mismatching lanes" << std::endl;
+
+    return passed;
+}
+
+// Mostly ordinary values with zeros of both signs, so axis parallel directions are covered
+static float GetTestFloat()
+{
+    float selector = RandomGenerator::GetRandomFloat();
+
+    if(selector < 0.05f) return 0.f;
+    if(selector < 0.1f) return -0.f;
+
+    return RandomGenerator::GetRandomFloat(-10.f, 10.f);
+}
+
+static Vector3 GetTestVector()
+{
+    return Vector3(GetTestFloat(), GetTestFloat(), GetTestFloat());
+}
+
+static Vector3x8 LoadVectors(const Vector3 *vectors)
+{
+    float xs[8], ys[8], zs[8];
+
+    for(int lane = 0; lane < 8; lane++)
+    {
+        xs[lane] = vectors[lane].x;
+        ys[lane] = vectors[lane].y;
+        zs[lane] = vectors[lane].z;
+    }
+
+    return Vector3x8::Load(xs, ys, zs);
+}
+
+static Matrix GetTestMatrix()
+{
+    Matrix matrix;
+
+    for(int i = 0; i < 16; i++)
+    {
+        matrix.m[i] = GetTestFloat();
+    }
+
+    return matrix;
+}
+
+static bool TestVectorPackets()
+{
+    unsigned int mismatchCount = 0;
+
+    for(unsigned int iteration = 0; iteration < SIMD_TEST_ITERATION_COUNT; iteration++)
+    {
+        Vector3 first[8], second[8];
+
+        for(int lane = 0; lane < 8; lane++)
+        {
+            first[lane] = GetTestVector();
+            second[lane] = GetTestVector();
+        }
+
+        Vector3x8 firstPacket = LoadVectors(first);
+        Vector3x8 secondPacket = LoadVectors(second);
+
+        Float8 dot = Vector3x8::Dot(firstPacket, secondPacket);
+        Vector3x8 cross = Vector3x8::Cross(firstPacket, secondPacket);
+        Vector3x8 sum = firstPacket + secondPacket;
+        Float8 length = firstPacket.Length();
+        Float8 minimum = Float8::Min(firstPacket.x, secondPacket.x);
+        Float8 maximum = Float8::Max(firstPacket.x, secondPacket.x);
+
+        for(int lane = 0; lane < 8; lane++)
+        {
+            mismatchCount += !SameBits(dot[lane], Vector3::Dot(first[lane], second[lane]));
+            mismatchCount += !SameBits(cross.GetLane(lane), Vector3::Cross(first[lane], second[lane]));
+            mismatchCount += !SameBits(sum.GetLane(lane), first[lane] + second[lane]);
+            mismatchCount += !SameBits(length[lane], first[lane].Length());
+            mismatchCount += !SameBits(minimum[lane], mathMin(first[lane].x, second[lane].x));
+            mismatchCount += !SameBits(maximum[lane], mathMax(first[lane].x, second[lane].x));
+        }
+    }
+
+    return Check("Vector3x8 against Vector3", mismatchCount);
+}
+
+static bool TestMatrixProducts()
+{
+    unsigned int mismatchCount = 0;
+
+    for(unsigned int iteration = 0; iteration < SIMD_TEST_ITERATION_COUNT; iteration++)
+    {
+        Matrix first = GetTestMatrix();
+        Matrix second = GetTestMatrix();
+
+        // Scalar row by column products in the order the packet products add
+        Matrix product = first * second;
+
+        for(int row = 0; row < 4; row++)
+        {
+            for(int column = 0; column < 4; column++)
+            {
+                float expected = first.m[row * 4] * second.m[column]
+                               + first.m[row * 4 + 1] * second.m[4 + column]
+                               + first.m[row * 4 + 2] * second.m[8 + column]
+                               + first.m[row * 4 + 3] * second.m[12 + column];
+
+                mismatchCount += !SameBits(product.m[row * 4 + column], expected);
+            }
+        }
+
+        Vector3 points[8], directions[8];
+
+        for(int lane = 0; lane < 8; lane++)
+        {
+            points[lane] = GetTestVector();
+            directions[lane] = GetTestVector();
+        }
+
+        Vector3x8 transformedPoints = first.TransformPoint(LoadVectors(points));
+        Vector3x8 transformedDirections = first.TransformDirection(LoadVectors(directions));
+
+        for(int lane = 0; lane < 8; lane++)
+        {
+            Vector4 point = first * Vector4(points[lane], 1.f);
+            Vector4 direction = first * Vector4(directions[lane], 0.f);
+
+            mismatchCount += !SameBits(point.x, first.m[0] * points[lane].x + first.m[1] * points[lane].y + first.m[2] * points[lane].z + first.m[3] * 1.f);
+            mismatchCount += !SameBits(transformedPoints.GetLane(lane), Vector3(point));
+            mismatchCount += !SameBits(transformedDirections.GetLane(lane), Vector3(direction));
+        }
+    }
+
+    return Check("Matrix products against scalar products", mismatchCount);
+}
+
+static bool TestSlabTest()
+{
+    unsigned int mismatchCount = 0;
+
+    for(unsigned int iteration = 0; iteration < SIMD_TEST_ITERATION_COUNT; iteration++)
+    {
+        Vector3 corner = GetTestVector();
+        BoundingVolume box(corner, corner + Vector3(RandomGenerator::GetRandomFloat(0.f, 5.f), RandomGenerator::GetRandomFloat(0.f, 5.f), RandomGenerator::GetRandomFloat(0.f, 5.f)));
+        box.left = nullptr;
+        box.right = nullptr;
+
+        Ray rays[8];
+
+        for(int lane = 0; lane < 8; lane++)
+        {
+            rays[lane] = Ray(GetTestVector(), GetTestVector(), 0.f, RandomGenerator::GetRandomFloat(0.f, 20.f));
+        }
+
+        int hitBits = box.SlabTest(RayPacket8::Load(rays, 8)).GetBits();
+
+        for(int lane = 0; lane < 8; lane++)
+        {
+            mismatchCount += (((hitBits >> lane) & 1) != 0) != box.SlabTest(rays[lane]);
+        }
+    }
+
+    return Check("Packet slab test against the ray slab test", mismatchCount);
+}
+
+// Shadow ray packets through a transformed triangle soup against the rays one by one
+static bool TestOcclusionTrace()
+{
+    Mesh *mesh = new Mesh();
+
+    for(unsigned int triangleIndex = 0; triangleIndex < SIMD_TEST_TRIANGLE_COUNT; triangleIndex++)
+    {
+        Vector3 center = GetTestVector();
+
+        Face *face = new Face();
+        face->v0 = mainScene->vertices.size() + 1;
+        face->v1 = mainScene->vertices.size() + 2;
+        face->v2 = mainScene->vertices.size() + 3;
+
+        mainScene->vertices.push_back(center + Vector3(RandomGenerator::GetRandomFloat(-1.f, 1.f), RandomGenerator::GetRandomFloat(-1.f, 1.f), RandomGenerator::GetRandomFloat(-1.f, 1.f)));
+        mainScene->vertices.push_back(center + Vector3(RandomGenerator::GetRandomFloat(-1.f, 1.f), RandomGenerator::GetRandomFloat(-1.f, 1.f), RandomGenerator::GetRandomFloat(-1.f, 1.f)));
+        mainScene->vertices.push_back(center + Vector3(RandomGenerator::GetRandomFloat(-1.f, 1.f), RandomGenerator::GetRandomFloat(-1.f, 1.f), RandomGenerator::GetRandomFloat(-1.f, 1.f)));
+
+        mesh->faces.push_back(face);
+    }
+
+    mesh->SetTransformationMatrix(Transformation::GetTranslationMatrix(Vector3(1.f, -2.f, 0.5f)) * Transformation::GetScalingMatrix(Vector3(1.5f, 0.75f, 2.f)));
+    mesh->SetInverseTransformationMatrix();
+    mesh->CreateBVH();
+
+    mainScene->objects.push_back(mesh);
+
+    unsigned int mismatchCount = 0;
+    unsigned int occludedCount = 0;
+
+    for(unsigned int iteration = 0; iteration < SIMD_TEST_ITERATION_COUNT; iteration++)
+    {
+        Ray rays[8];
+
+        for(int lane = 0; lane < 8; lane++)
+        {
+            rays[lane] = Ray(GetTestVector(), GetTestVector(), 0.f, RandomGenerator::GetRandomFloat(0.f, 20.f));
+        }
+
+        // The last lanes are left out to cover partially filled packets
+        int rayCount = 1 + iteration % 8;
+        int occludedBits = mainScene->OcclusionTrace(RayPacket8::Load(rays, rayCount), Mask8::FromBits((1 << rayCount) - 1)).GetBits();
+
+        mismatchCount += (occludedBits >> rayCount) != 0;
+
+        for(int lane = 0; lane < rayCount; lane++)
+        {
+            bool occluded = mainScene->OcclusionTrace(rays[lane]);
+
+            mismatchCount += (((occludedBits >> lane) & 1) != 0) != occluded;
+            occludedCount += occluded;
+        }
+    }
+
+    std::cout << occludedCount << " of the rays are occluded" << std::endl;
+
+    return Check("Packet occlusion trace against the ray occlusion trace", mismatchCount);
+}
+
+int main()
+{
+    Scene scene;
+
+    bool passed = TestVectorPackets();
+    passed &= TestMatrixProducts();
+    passed &= TestSlabTest();
+    passed &= TestOcclusionTrace();
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,209 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <cstdlib>
+
+#include "Math.h"
+#include "Topology.h"
+
+std::vector<std::thread> ThreadPool::workers;
+std::deque<ThreadPool::Task> ThreadPool::tasks;
+
+std::mutex ThreadPool::mutex;
+std::condition_variable ThreadPool::taskCondition;
+std::condition_variable ThreadPool::doneCondition;
+bool ThreadPool::stopping = false;
+
+unsigned int ThreadPool::threadCount = 1;
+
+void TaskGroup::Run(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(ThreadPool::mutex);
+        pendingTaskCount++;
+        ThreadPool::tasks.push_back(ThreadPool::Task{ std::move(task), this });
+    }
+
+    ThreadPool::taskCondition.notify_one();
+}
+
+void TaskGroup::Wait()
+{
+    std::unique_lock<std::mutex> lock(ThreadPool::mutex);
+
+    while(pendingTaskCount > 0)
+    {
+        // The queued tasks may belong to other groups, running them still brings this group closer to its end
+        if(!ThreadPool::tasks.empty())
+        {
+            ThreadPool::Task task = std::move(ThreadPool::tasks.front());
+            ThreadPool::tasks.pop_front();
+
+            ThreadPool::RunTask(task, lock);
+        }
+        else
+        {
+            ThreadPool::doneCondition.wait(lock);
+        }
+    }
+}
+
+void ThreadPool::Initialize(unsigned int threadCount)
+{
+    if(threadCount == 0)
+    {
+        threadCount = std::thread::hardware_concurrency();
+        if(threadCount == 0) threadCount = 1;
+    }
+
+    if(threadCount == ThreadPool::threadCount && workers.size() + 1 == threadCount)
+    {
+        return;
+    }
+
+    Shutdown();
+
+    ThreadPool::threadCount = threadCount;
+
+    // The calling thread takes the place of thread 0
+    Topology::PlaceCurrentThread(0);
+
+    for(unsigned int threadIndex = 1; threadIndex < threadCount; threadIndex++)
+    {
+        workers.push_back(std::thread(&ThreadPool::WorkerFunction, threadIndex));
+    }
+}
+
+void ThreadPool::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    taskCondition.notify_all();
+
+    for(auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    workers.clear();
+    stopping = false;
+    threadCount = 1;
+}
+
+void ThreadPool::Run(const std::function<void(unsigned int)> &function)
+{
+    TaskGroup group;
+
+    for(unsigned int threadIndex = 1; threadIndex < threadCount; threadIndex++)
+    {
+        group.Run([&function, threadIndex]{ function(threadIndex); });
+    }
+
+    function(0);
+
+    group.Wait();
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &function)
+{
+    if(count == 0)
+    {
+        return;
+    }
+
+    if(grainSize == 0) grainSize = 1;
+
+    size_t chunkCount = (count + grainSize - 1) / grainSize;
+
+    if(chunkCount == 1)
+    {
+        function(0, count);
+        return;
+    }
+
+    std::atomic<size_t> nextChunk(0);
+
+    auto chunkLoop = [&]
+    {
+        size_t chunk;
+        while((chunk = nextChunk.fetch_add(1, std::memory_order_relaxed)) < chunkCount)
+        {
+            size_t begin = chunk * grainSize;
+            function(begin, mathMin(count, begin + grainSize));
+        }
+    };
+
+    // Threads that come late find no chunk left and return at once
+    TaskGroup group;
+
+    size_t helperCount = mathMin((size_t)threadCount, chunkCount) - 1;
+    for(size_t helperIndex = 0; helperIndex < helperCount; helperIndex++)
+    {
+        group.Run(chunkLoop);
+    }
+
+    chunkLoop();
+
+    group.Wait();
+}
+
+unsigned int ThreadPool::ParseThreadCount(const char *text)
+{
+    if(text == nullptr)
+    {
+        return 0;
+    }
+
+    char *end;
+    long value = strtol(text, &end, 10);
+
+    if(end == text || *end != '\0' || value <= 0)
+    {
+        return 0;
+    }
+
+    return (unsigned int)value;
+}
+
+void ThreadPool::WorkerFunction(unsigned int threadIndex)
+{
+    Topology::PlaceCurrentThread(threadIndex);
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while(true)
+    {
+        taskCondition.wait(lock, []{ return stopping || !tasks.empty(); });
+
+        if(stopping)
+        {
+            return;
+        }
+
+        Task task = std::move(tasks.front());
+        tasks.pop_front();
+
+        RunTask(task, lock);
+    }
+}
+
+void ThreadPool::RunTask(Task &task, std::unique_lock<std::mutex> &lock)
+{
+    lock.unlock();
+    task.function();
+    lock.lock();
+
+    if(--task.group->pendingTaskCount == 0)
+    {
+        doneCondition.notify_all();
+    }
+}
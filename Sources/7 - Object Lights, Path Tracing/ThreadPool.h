@@ -0,0 +1,110 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Environment variable overriding the scene's thread count
+#define THREAD_COUNT_ENVIRONMENT_VARIABLE "RAYTRACER_THREADS"
+
+/*
+    Set of tasks queued on the thread pool that can be waited for together
+    Groups can be created inside tasks, a waiting thread runs queued tasks instead of blocking
+*/
+class TaskGroup
+{
+public:
+    TaskGroup()
+    {
+
+    }
+
+    ~TaskGroup()
+    {
+        Wait();
+    }
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    // Queues the task on the pool
+    void Run(std::function<void()> task);
+
+    // Returns when every task of the group is done
+    void Wait();
+
+private:
+    friend class ThreadPool;
+
+    // Guarded by the pool's mutex
+    unsigned int pendingTaskCount = 0;
+};
+
+/*
+    Static persistent worker pool
+    The workers are created once and run the tasks of a shared queue, threads waiting for a group help them
+*/
+class ThreadPool
+{
+public:
+    // Starts the pool with threadCount threads including the calling thread
+    // 0 uses the hardware thread count, calling it again resizes the pool
+    // Every thread is placed by Topology before it runs any task
+    static void Initialize(unsigned int threadCount = 0);
+
+    // Stops and joins the workers
+    static void Shutdown();
+
+    // Runs function(threadIndex) once for every thread index of the pool and returns when all of them are done
+    // Indices are unique within one call only, concurrent calls each hand out 0 to threadCount - 1 and any thread may run any index
+    // State indexed by them has to belong to the call, like the TileScheduler every render pass creates
+    static void Run(const std::function<void(unsigned int)> &function);
+
+    // Splits [0, count) into chunks of grainSize elements and hands them out to the threads as they finish
+    // The chunks do not depend on the thread count, so per chunk results can be combined deterministically
+    static void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &function);
+
+    // Parses a thread count option, returns 0 when it is not a positive number
+    static unsigned int ParseThreadCount(const char *text);
+
+    static inline unsigned int GetThreadCount()
+    {
+        return threadCount;
+    }
+
+private:
+    friend class TaskGroup;
+
+    struct Task
+    {
+        std::function<void()> function;
+        TaskGroup *group;
+    };
+
+    static void WorkerFunction(unsigned int threadIndex);
+
+    // Runs the task and marks it done in its group, the lock is released while the task runs
+    static void RunTask(Task &task, std::unique_lock<std::mutex> &lock);
+
+    static std::vector<std::thread> workers;
+    static std::deque<Task> tasks;
+
+    static std::mutex mutex;
+    static std::condition_variable taskCondition;
+    static std::condition_variable doneCondition;
+    static bool stopping;
+
+    static unsigned int threadCount;
+};
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#include "TileScheduler.h"
+
+#include <algorithm>
+
+#include "Math.h"
+
+TileScheduler::TileScheduler(int imageWidth, int imageHeight, int tileSize, TILE_ORDER order, unsigned int threadCount) :
+    queues(threadCount),
+    imageWidth(imageWidth),
+    imageHeight(imageHeight),
+    tileSize(tileSize > 0 ? tileSize : DEFAULT_TILE_SIZE)
+{
+    tileCountX = (imageWidth + this->tileSize - 1) / this->tileSize;
+    tileCountY = (imageHeight + this->tileSize - 1) / this->tileSize;
+
+    tiles.reserve(tileCountX * tileCountY);
+
+    if(order == TILE_ORDER::SPIRAL)
+    {
+        CreateSpiralOrder();
+    }
+    else
+    {
+        CreateHilbertOrder();
+    }
+
+    // Every thread starts with a contiguous piece of the curve, so the tiles it renders stay close to each other
+    // Thieves take from the far end of a piece, away from the tiles its owner is working on
+    size_t tileCount = tiles.size();
+
+    for(unsigned int threadIndex = 0; threadIndex < threadCount; threadIndex++)
+    {
+        size_t firstTile = tileCount * threadIndex / threadCount;
+        size_t lastTile = tileCount * (threadIndex + 1) / threadCount;
+
+        for(size_t tileIndex = firstTile; tileIndex < lastTile; tileIndex++)
+        {
+            queues[threadIndex].tileIndices.push_back(tileIndex);
+        }
+    }
+}
+
+bool TileScheduler::GetNextTile(unsigned int threadIndex, Tile &tile)
+{
+    unsigned int threadCount = queues.size();
+
+    {
+        TileQueue &ownQueue = queues[threadIndex];
+        std::lock_guard<std::mutex> lock(ownQueue.mutex);
+
+        if(!ownQueue.tileIndices.empty())
+        {
+            tile = tiles[ownQueue.tileIndices.front()];
+            ownQueue.tileIndices.pop_front();
+            return true;
+        }
+    }
+
+    for(unsigned int victimOffset = 1; victimOffset < threadCount; victimOffset++)
+    {
+        TileQueue &victimQueue = queues[(threadIndex + victimOffset) % threadCount];
+        std::lock_guard<std::mutex> lock(victimQueue.mutex);
+
+        if(!victimQueue.tileIndices.empty())
+        {
+            tile = tiles[victimQueue.tileIndices.back()];
+            victimQueue.tileIndices.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TileScheduler::AddTile(int tileX, int tileY)
+{
+    if(tileX < 0 || tileY < 0 || tileX >= tileCountX || tileY >= tileCountY)
+    {
+        return false;
+    }
+
+    Tile tile;
+    tile.startX = tileX * tileSize;
+    tile.startY = tileY * tileSize;
+    tile.width = mathMin(tileSize, imageWidth - tile.startX);
+    tile.height = mathMin(tileSize, imageHeight - tile.startY);
+    tile.index = tiles.size();
+
+    tiles.push_back(tile);
+
+    return true;
+}
+
+void TileScheduler::CreateHilbertOrder()
+{
+    // The curve covers the smallest power of two grid containing the tile grid, positions outside are skipped
+    int curveSize = 1;
+    while(curveSize < tileCountX || curveSize < tileCountY)
+    {
+        curveSize <<= 1;
+    }
+
+    int curveLength = curveSize * curveSize;
+
+    for(int curveIndex = 0; curveIndex < curveLength; curveIndex++)
+    {
+        int tileX = 0, tileY = 0;
+        int remaining = curveIndex;
+
+        for(int quadrantSize = 1; quadrantSize < curveSize; quadrantSize <<= 1)
+        {
+            int rx = 1 & (remaining / 2);
+            int ry = 1 & (remaining ^ rx);
+
+            // Rotate the quadrant
+            if(ry == 0)
+            {
+                if(rx == 1)
+                {
+                    tileX = quadrantSize - 1 - tileX;
+                    tileY = quadrantSize - 1 - tileY;
+                }
+
+                std::swap(tileX, tileY);
+            }
+
+            tileX += quadrantSize * rx;
+            tileY += quadrantSize * ry;
+            remaining /= 4;
+        }
+
+        AddTile(tileX, tileY);
+    }
+}
+
+void TileScheduler::CreateSpiralOrder()
+{
+    // Walks outwards from the center tile, turning right after every leg and growing the legs every two turns
+    int tileCount = tileCountX * tileCountY;
+    int addedTileCount = 0;
+
+    int tileX = (tileCountX - 1) / 2;
+    int tileY = (tileCountY - 1) / 2;
+
+    if(AddTile(tileX, tileY)) addedTileCount++;
+
+    const int stepX[4] = { 1, 0, -1, 0 };
+    const int stepY[4] = { 0, 1, 0, -1 };
+
+    int direction = 0;
+
+    for(int legLength = 1; addedTileCount < tileCount; legLength++)
+    {
+        for(int leg = 0; leg < 2; leg++)
+        {
+            for(int step = 0; step < legLength; step++)
+            {
+                tileX += stepX[direction];
+                tileY += stepY[direction];
+
+                if(AddTile(tileX, tileY)) addedTileCount++;
+            }
+
+            direction = (direction + 1) % 4;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#ifndef __TILESCHEDULER_H__
+#define __TILESCHEDULER_H__
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#define DEFAULT_TILE_SIZE 16
+
+enum class TILE_ORDER : uint8_t
+{
+    HILBERT = 0,
+    SPIRAL
+};
+
+struct Tile
+{
+    int startX, startY;
+    int width, height;
+
+    // Position of the tile in the scheduler's order
+    unsigned int index;
+};
+
+/*
+    Image tile scheduler
+    Cuts the image into tiles ordered along a curve and deals them out to the threads
+    Every thread takes tiles from the front of its own deque and steals from the back of the others when it runs out
+*/
+class TileScheduler
+{
+public:
+    TileScheduler(int imageWidth, int imageHeight, int tileSize, TILE_ORDER order, unsigned int threadCount);
+
+    // Gets the next tile of the thread, returns false when there is no tile left in any deque
+    bool GetNextTile(unsigned int threadIndex, Tile &tile);
+
+    inline size_t GetTileCount() const
+    {
+        return tiles.size();
+    }
+
+    inline const Tile &GetTile(size_t tileIndex) const
+    {
+        return tiles[tileIndex];
+    }
+
+private:
+    // Work deque of a thread, holds indices to the tiles
+    struct TileQueue
+    {
+        std::mutex mutex;
+        std::deque<unsigned int> tileIndices;
+    };
+
+    // Appends the tile at the tile grid position (x, y), returns false if it is outside the image
+    bool AddTile(int tileX, int tileY);
+
+    void CreateHilbertOrder();
+    void CreateSpiralOrder();
+
+    std::vector<Tile> tiles;
+    std::vector<TileQueue> queues;
+
+    int imageWidth, imageHeight;
+    int tileSize;
+    int tileCountX, tileCountY;
+};
+
+#endif
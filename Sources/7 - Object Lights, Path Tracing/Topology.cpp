@@ -0,0 +1,253 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#include "Topology.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define NODE_DIRECTORY "/sys/devices/system/node/"
+#define MAX_NODE_COUNT 1024
+
+std::vector<NumaNode> Topology::nodes;
+
+bool Topology::pinThreads = false;
+MEMORY_POLICY Topology::memoryPolicy = MEMORY_POLICY::LOCAL;
+
+std::atomic<bool> Topology::pinningFailed(false);
+std::atomic<bool> Topology::memoryPolicyFailed(false);
+
+// Parses a kernel list such as "0-3,8,10-11", returns false when the file cannot be read
+static bool ReadIndexList(const std::string &fileName, std::vector<unsigned int> &indices)
+{
+    std::ifstream file(fileName);
+    std::string line;
+
+    if(!file || !std::getline(file, line))
+    {
+        return false;
+    }
+
+    const char *text = line.c_str();
+
+    while(*text != '\0')
+    {
+        char *end;
+        unsigned long first = strtoul(text, &end, 10);
+        if(end == text) break;
+
+        unsigned long last = first;
+        text = end;
+
+        if(*text == '-')
+        {
+            last = strtoul(text + 1, &end, 10);
+            text = end;
+        }
+
+        for(unsigned long index = first; index <= last; index++)
+        {
+            indices.push_back((unsigned int)index);
+        }
+
+        if(*text == ',') text++;
+        else break;
+    }
+
+    return true;
+}
+
+void Topology::Detect()
+{
+    nodes.clear();
+
+    cpu_set_t allowedCpus;
+    CPU_ZERO(&allowedCpus);
+    bool hasAllowedCpus = sched_getaffinity(0, sizeof(allowedCpus), &allowedCpus) == 0;
+
+    std::vector<unsigned int> onlineNodes;
+    if(ReadIndexList(NODE_DIRECTORY "online", onlineNodes))
+    {
+        for(unsigned int nodeIndex : onlineNodes)
+        {
+            std::vector<unsigned int> nodeCpus;
+            ReadIndexList(NODE_DIRECTORY "node" + std::to_string(nodeIndex) + "/cpulist", nodeCpus);
+
+            NumaNode node;
+            node.index = nodeIndex;
+
+            for(unsigned int cpu : nodeCpus)
+            {
+                if(!hasAllowedCpus || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowedCpus)))
+                {
+                    node.cpus.push_back(cpu);
+                }
+            }
+
+            // Nodes with memory only or without allowed cpus get no threads
+            if(!node.cpus.empty())
+            {
+                nodes.push_back(node);
+            }
+        }
+    }
+
+    if(nodes.empty())
+    {
+        NumaNode node;
+        node.index = 0;
+
+        if(hasAllowedCpus)
+        {
+            for(unsigned int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                if(CPU_ISSET(cpu, &allowedCpus)) node.cpus.push_back(cpu);
+            }
+        }
+
+        if(node.cpus.empty())
+        {
+            unsigned int cpuCount = std::thread::hardware_concurrency();
+            for(unsigned int cpu = 0; cpu < (cpuCount > 0 ? cpuCount : 1); cpu++)
+            {
+                node.cpus.push_back(cpu);
+            }
+        }
+
+        nodes.push_back(node);
+    }
+}
+
+void Topology::SetPlacement(bool pinThreads, MEMORY_POLICY memoryPolicy)
+{
+    Topology::pinThreads = pinThreads;
+    Topology::memoryPolicy = memoryPolicy;
+
+    pinningFailed = false;
+    memoryPolicyFailed = false;
+}
+
+void Topology::PlaceCurrentThread(unsigned int threadIndex)
+{
+    if(nodes.empty())
+    {
+        return;
+    }
+
+    if(pinThreads)
+    {
+        unsigned int nodeIndex;
+        unsigned int cpu = GetCpuOfThread(threadIndex, nodeIndex);
+
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu, &cpuSet);
+
+        if(pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0)
+        {
+            pinningFailed = true;
+        }
+    }
+
+    // The policy is per thread, so it is set on every thread allocating scene data
+    // The system call is used directly to avoid a dependency on libnuma
+    if(memoryPolicy == MEMORY_POLICY::INTERLEAVE)
+    {
+        unsigned long nodeMask[MAX_NODE_COUNT / (8 * sizeof(unsigned long))] = {};
+
+        std::vector<unsigned int> memoryNodes;
+        if(!ReadIndexList(NODE_DIRECTORY "has_memory", memoryNodes))
+        {
+            for(const NumaNode &node : nodes) memoryNodes.push_back(node.index);
+        }
+
+        for(unsigned int nodeIndex : memoryNodes)
+        {
+            if(nodeIndex < MAX_NODE_COUNT)
+            {
+                nodeMask[nodeIndex / (8 * sizeof(unsigned long))] |= 1ul << (nodeIndex % (8 * sizeof(unsigned long)));
+            }
+        }
+
+        if(syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, nodeMask, (unsigned long)MAX_NODE_COUNT) != 0)
+        {
+            memoryPolicyFailed = true;
+        }
+    }
+}
+
+void Topology::PrintReport(unsigned int threadCount)
+{
+    unsigned int cpuCount = 0;
+    for(const NumaNode &node : nodes) cpuCount += node.cpus.size();
+
+    std::cout << "Topology: " << nodes.size() << (nodes.size() == 1 ? " node, " : " nodes, ") << cpuCount << " cpus." << std::endl;
+
+    for(const NumaNode &node : nodes)
+    {
+        std::cout << "  Node " << node.index << ": cpus";
+        for(unsigned int cpu : node.cpus) std::cout << " " << cpu;
+
+        std::cout << ", threads";
+        unsigned int nodeThreadCount = 0;
+
+        for(unsigned int threadIndex = 0; threadIndex < threadCount; threadIndex++)
+        {
+            unsigned int nodeIndex;
+            unsigned int cpu = GetCpuOfThread(threadIndex, nodeIndex);
+
+            if(nodeIndex == node.index)
+            {
+                std::cout << " " << threadIndex;
+                if(pinThreads) std::cout << "->" << cpu;
+                nodeThreadCount++;
+            }
+        }
+
+        if(nodeThreadCount == 0) std::cout << " none";
+        std::cout << std::endl;
+    }
+
+    std::cout << "  Threads " << (pinThreads ? (pinningFailed ? "could not be pinned" : "pinned") : "not pinned")
+              << ", memory policy " << (memoryPolicy == MEMORY_POLICY::INTERLEAVE ? "interleave" : "local")
+              << (memoryPolicyFailed ? " could not be set." : ".") << std::endl;
+}
+
+bool Topology::ParseMemoryPolicy(const char *text, MEMORY_POLICY &memoryPolicy)
+{
+    if(strcmp(text, "Local") == 0 || strcmp(text, "local") == 0)
+    {
+        memoryPolicy = MEMORY_POLICY::LOCAL;
+    }
+    else if(strcmp(text, "Interleave") == 0 || strcmp(text, "interleave") == 0)
+    {
+        memoryPolicy = MEMORY_POLICY::INTERLEAVE;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+unsigned int Topology::GetCpuOfThread(unsigned int threadIndex, unsigned int &nodeIndex)
+{
+    const NumaNode &node = nodes[threadIndex % nodes.size()];
+    nodeIndex = node.index;
+
+    return node.cpus[(threadIndex / nodes.size()) % node.cpus.size()];
+}
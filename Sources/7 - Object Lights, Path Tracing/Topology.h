@@ -0,0 +1,65 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#ifndef __TOPOLOGY_H__
+#define __TOPOLOGY_H__
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+enum class MEMORY_POLICY : uint8_t
+{
+    // Pages are placed on the node of the thread touching them first
+    LOCAL = 0,
+    // Pages are spread over all the nodes
+    INTERLEAVE
+};
+
+struct NumaNode
+{
+    unsigned int index;
+    std::vector<unsigned int> cpus;
+};
+
+/*
+    Static NUMA topology of the machine
+    Places the pool threads on the cpus and sets the memory policy of their allocations
+*/
+class Topology
+{
+public:
+    // Reads the nodes and their cpus, limited to the cpus the process may run on
+    // Falls back to a single node when the system does not report any
+    static void Detect();
+
+    // Sets the placement applied by PlaceCurrentThread
+    static void SetPlacement(bool pinThreads, MEMORY_POLICY memoryPolicy);
+
+    // Pins the calling thread to the cpu of the thread index and applies the memory policy
+    // Thread indices are spread over the nodes first, so every node gets a similar share of the threads
+    static void PlaceCurrentThread(unsigned int threadIndex);
+
+    // Prints the nodes and the placement of threadCount threads
+    static void PrintReport(unsigned int threadCount);
+
+    // Parses a memory policy option, returns false when it is unknown
+    static bool ParseMemoryPolicy(const char *text, MEMORY_POLICY &memoryPolicy);
+
+private:
+    static unsigned int GetCpuOfThread(unsigned int threadIndex, unsigned int &nodeIndex);
+
+    static std::vector<NumaNode> nodes;
+
+    static bool pinThreads;
+    static MEMORY_POLICY memoryPolicy;
+
+    // Set by the threads whose placement failed, shown in the report
+    static std::atomic<bool> pinningFailed;
+    static std::atomic<bool> memoryPolicyFailed;
+};
+
+#endif
@@ -0,0 +1,669 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#include "WavefrontRenderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#include "BRDF.h"
+#include "Light.h"
+#include "LightMesh.h"
+#include "LightSphere.h"
+#include "Material.h"
+#include "ObjectBase.h"
+#include "ProgressReporter.h"
+#include "RandomGenerator.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "Texture.h"
+#include "ThreadPool.h"
+
+// Upper limit of the shadow queue entries, batches get smaller as the light count increases
+#define WAVEFRONT_MAX_SHADOW_RAYS (1 << 20)
+#define WAVEFRONT_MAX_BATCH_SIZE (1 << 16)
+#define WAVEFRONT_MIN_BATCH_SIZE (1 << 12)
+
+// Chunks smaller than this are not worth handing out to the worker threads
+#define WAVEFRONT_MIN_PARALLEL_COUNT 256
+
+// Bits per axis of the origin cell used by the sort key, 3 * 9 bits + 3 octant bits fit in 32 bits
+#define WAVEFRONT_SORT_CELL_BITS 9
+
+// Coarser cell used when measuring coherence
+#define WAVEFRONT_COHERENCE_CELL_BITS 4
+
+// Continues the path's random sequence on the current thread and stores it back when the path is shaded
+struct PathRandomScope
+{
+    PathRandomScope(SampleState &pathState) : state(pathState)
+    {
+        RandomGenerator::SetState(state);
+    }
+
+    ~PathRandomScope()
+    {
+        state = RandomGenerator::GetState();
+    }
+
+    SampleState &state;
+};
+
+// Spreads the lower 10 bits of value so that there are two zero bits between each
+static inline uint32_t ExpandBits(uint32_t value)
+{
+    value &= 0x000003ff;
+    value = (value | (value << 16)) & 0xff0000ff;
+    value = (value | (value << 8)) & 0x0300f00f;
+    value = (value | (value << 4)) & 0x030c30c3;
+    value = (value | (value << 2)) & 0x09249249;
+    return value;
+}
+
+// Direction octant in the top 3 bits, interleaved origin cell coordinates in the rest
+static inline uint32_t GetSortKey(uint32_t octant, uint32_t cellX, uint32_t cellY, uint32_t cellZ)
+{
+    return (octant << (3 * WAVEFRONT_SORT_CELL_BITS)) | (ExpandBits(cellZ) << 2) | (ExpandBits(cellY) << 1) | ExpandBits(cellX);
+}
+
+static inline bool IsCoherent(uint32_t key, uint32_t previousKey)
+{
+    return (key >> (3 * (WAVEFRONT_SORT_CELL_BITS - WAVEFRONT_COHERENCE_CELL_BITS))) == (previousKey >> (3 * (WAVEFRONT_SORT_CELL_BITS - WAVEFRONT_COHERENCE_CELL_BITS)));
+}
+
+void RayQueue::Resize(size_t capacity)
+{
+    originX.resize(capacity);
+    originY.resize(capacity);
+    originZ.resize(capacity);
+
+    directionX.resize(capacity);
+    directionY.resize(capacity);
+    directionZ.resize(capacity);
+
+    throughputR.resize(capacity);
+    throughputG.resize(capacity);
+    throughputB.resize(capacity);
+
+    emissionWeightR.resize(capacity);
+    emissionWeightG.resize(capacity);
+    emissionWeightB.resize(capacity);
+
+    bouncePdf.resize(capacity);
+
+    bounceNormalX.resize(capacity);
+    bounceNormalY.resize(capacity);
+    bounceNormalZ.resize(capacity);
+
+    pathIndex.resize(capacity);
+}
+
+void HitQueue::Resize(size_t capacity)
+{
+    t.resize(capacity);
+
+    normalX.resize(capacity);
+    normalY.resize(capacity);
+    normalZ.resize(capacity);
+
+    beta.resize(capacity);
+    gamma.resize(capacity);
+
+    object.resize(capacity);
+}
+
+void ShadowQueue::Resize(size_t capacity)
+{
+    positionX.resize(capacity);
+    positionY.resize(capacity);
+    positionZ.resize(capacity);
+
+    lightPositionX.resize(capacity);
+    lightPositionY.resize(capacity);
+    lightPositionZ.resize(capacity);
+
+    contributionR.resize(capacity);
+    contributionG.resize(capacity);
+    contributionB.resize(capacity);
+
+    lightIndex.resize(capacity);
+
+    active.resize(capacity);
+}
+
+void WavefrontRenderer::RenderImage(const Camera *camera, int imageWidth, int imageHeight, float *colorBuffer)
+{
+    const RendererInfo ri(camera, camera - mainScene->cameras.data());
+
+    unsigned int sampleCount = camera->numberOfSamples > 0 ? camera->numberOfSamples : 1;
+    size_t slotCount = Renderer::GetMaxSelectedLightCount();
+
+    size_t totalPathCount = (size_t)imageWidth * imageHeight * sampleCount;
+    size_t batchSize = WAVEFRONT_MAX_SHADOW_RAYS / (slotCount > 0 ? slotCount : 1);
+    batchSize = mathClamp(batchSize, WAVEFRONT_MIN_BATCH_SIZE, WAVEFRONT_MAX_BATCH_SIZE);
+
+    std::fill(colorBuffer, colorBuffer + (size_t)imageWidth * imageHeight * 3, 0.f);
+
+    WavefrontBatch batch;
+    batch.rays.Resize(batchSize);
+    batch.nextRays.Resize(batchSize);
+    batch.hits.Resize(batchSize);
+    batch.shadows.Resize(batchSize * slotCount);
+    batch.radiance.resize(batchSize);
+    batch.randomStates.resize(batchSize);
+    batch.sortKeys.resize(batchSize);
+
+    WavefrontStatistics statistics;
+
+    for(size_t firstPath = 0; firstPath < totalPathCount; firstPath += batchSize)
+    {
+        batch.firstPath = firstPath;
+        batch.pathCount = mathMin(batchSize, totalPathCount - firstPath);
+
+        GenerateStage(batch, ri, imageWidth, sampleCount);
+
+        for(unsigned int depth = 0; depth < mainScene->maxRecursionDepth && batch.rays.size > 0; depth++)
+        {
+            if(depth > 0)
+            {
+                SortStage(batch, statistics);
+
+                std::chrono::high_resolution_clock::time_point extendStart = std::chrono::high_resolution_clock::now();
+                ExtendStage(batch);
+                statistics.secondaryExtendSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - extendStart).count();
+            }
+            else
+            {
+                ExtendStage(batch);
+            }
+
+            ShadeStage(batch, depth);
+            ShadowStage(batch);
+            AccumulateStage(batch);
+
+            std::swap(batch.rays, batch.nextRays);
+        }
+
+        ResolveStage(batch, sampleCount, colorBuffer);
+
+        // Pixels whose last sample is in this batch are done
+        ProgressReporter::AddPixels((firstPath + batch.pathCount) / sampleCount - firstPath / sampleCount);
+    }
+
+    if(statistics.secondaryRayCount > 0)
+    {
+        // Cameras may finish concurrently, the line is built first so it is printed in one piece
+        std::ostringstream report;
+
+        report << "Secondary rays: " << statistics.secondaryRayCount
+               << ", coherent neighbours: " << statistics.coherentPairsBeforeSort * 100.0 / statistics.secondaryRayCount << "%";
+
+        if(mainScene->sortSecondaryRays)
+        {
+            report << " -> " << statistics.coherentPairsAfterSort * 100.0 / statistics.secondaryRayCount << "% after sorting"
+                   << ", sort time: " << statistics.sortSeconds << " seconds";
+        }
+
+        report << ", secondary trace time: " << statistics.secondaryExtendSeconds << " seconds.\n";
+
+        std::cout << report.str() << std::flush;
+    }
+}
+
+void WavefrontRenderer::GenerateStage(WavefrontBatch &batch, const RendererInfo &ri, int imageWidth, unsigned int sampleCount)
+{
+    RayQueue &rays = batch.rays;
+
+    // The first strataCount^2 pixel samples are stratified on a grid, a partial row of cells would leave part of the pixel uncovered
+    unsigned int strataCount = mathMax((unsigned int)sqrt((float)sampleCount), 1u);
+
+    ParallelFor(batch.pathCount, [&](size_t begin, size_t end)
+    {
+        for(size_t pathIndex = begin; pathIndex < end; pathIndex++)
+        {
+            size_t globalPathIndex = batch.firstPath + pathIndex;
+            size_t pixelIndex = globalPathIndex / sampleCount;
+            unsigned int sampleIndex = globalPathIndex % sampleCount;
+
+            float x = (float)(pixelIndex % imageWidth);
+            float y = (float)(pixelIndex / imageWidth);
+
+            RandomGenerator::StartSample(pixelIndex, sampleIndex, ri.frameIndex);
+
+            if(sampleCount == 1)
+            {
+                x += 0.5f;
+                y += 0.5f;
+            }
+            else if(sampleIndex < strataCount * strataCount)
+            {
+                x += ((sampleIndex % strataCount) + RandomGenerator::GetSample(SAMPLE_PIXEL_DIMENSION)) / strataCount;
+                y += ((sampleIndex / strataCount) + RandomGenerator::GetSample(SAMPLE_PIXEL_DIMENSION + 1)) / strataCount;
+            }
+            else
+            {
+                // The samples beyond the grid are spread uniformly over the pixel
+                x += RandomGenerator::GetSample(SAMPLE_PIXEL_DIMENSION);
+                y += RandomGenerator::GetSample(SAMPLE_PIXEL_DIMENSION + 1);
+            }
+
+            Ray ray = Renderer::GetPrimaryRay(x, y, ri);
+
+            rays.Set(pathIndex, ray.e, ray.dir, Vector3(1.f), pathIndex);
+            batch.radiance[pathIndex] = Vector3::ZeroVector;
+            batch.randomStates[pathIndex] = RandomGenerator::GetState();
+        }
+    });
+
+    rays.size = batch.pathCount;
+}
+
+void WavefrontRenderer::SortStage(WavefrontBatch &batch, WavefrontStatistics &statistics)
+{
+    std::chrono::high_resolution_clock::time_point sortStart = std::chrono::high_resolution_clock::now();
+
+    RayQueue &rays = batch.rays;
+    std::vector<uint64_t> &sortKeys = batch.sortKeys;
+
+    // Origin cells are relative to the bounds of the queued origins
+    Vector3 min(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT);
+    Vector3 max(-MAX_FLOAT, -MAX_FLOAT, -MAX_FLOAT);
+
+    for(size_t rayIndex = 0; rayIndex < rays.size; rayIndex++)
+    {
+        if(rays.originX[rayIndex] < min.x) min.x = rays.originX[rayIndex];
+        if(rays.originY[rayIndex] < min.y) min.y = rays.originY[rayIndex];
+        if(rays.originZ[rayIndex] < min.z) min.z = rays.originZ[rayIndex];
+
+        if(rays.originX[rayIndex] > max.x) max.x = rays.originX[rayIndex];
+        if(rays.originY[rayIndex] > max.y) max.y = rays.originY[rayIndex];
+        if(rays.originZ[rayIndex] > max.z) max.z = rays.originZ[rayIndex];
+    }
+
+    float cellCount = (float)(1 << WAVEFRONT_SORT_CELL_BITS);
+    Vector3 extent = max - min;
+    Vector3 cellScale(extent.x > 0.f ? cellCount / extent.x : 0.f,
+                      extent.y > 0.f ? cellCount / extent.y : 0.f,
+                      extent.z > 0.f ? cellCount / extent.z : 0.f);
+    uint32_t maxCell = (1 << WAVEFRONT_SORT_CELL_BITS) - 1;
+
+    ParallelFor(rays.size, [&](size_t begin, size_t end)
+    {
+        for(size_t rayIndex = begin; rayIndex < end; rayIndex++)
+        {
+            uint32_t octant = (rays.directionX[rayIndex] < 0.f ? 1 : 0) | (rays.directionY[rayIndex] < 0.f ? 2 : 0) | (rays.directionZ[rayIndex] < 0.f ? 4 : 0);
+
+            uint32_t cellX = mathMin((uint32_t)((rays.originX[rayIndex] - min.x) * cellScale.x), maxCell);
+            uint32_t cellY = mathMin((uint32_t)((rays.originY[rayIndex] - min.y) * cellScale.y), maxCell);
+            uint32_t cellZ = mathMin((uint32_t)((rays.originZ[rayIndex] - min.z) * cellScale.z), maxCell);
+
+            sortKeys[rayIndex] = ((uint64_t)GetSortKey(octant, cellX, cellY, cellZ) << 32) | rayIndex;
+        }
+    });
+
+    statistics.secondaryRayCount += rays.size;
+
+    for(size_t rayIndex = 1; rayIndex < rays.size; rayIndex++)
+    {
+        if(IsCoherent(sortKeys[rayIndex] >> 32, sortKeys[rayIndex - 1] >> 32))
+        {
+            statistics.coherentPairsBeforeSort++;
+        }
+    }
+
+    if(!mainScene->sortSecondaryRays)
+    {
+        return;
+    }
+
+    std::sort(sortKeys.begin(), sortKeys.begin() + rays.size);
+
+    for(size_t rayIndex = 1; rayIndex < rays.size; rayIndex++)
+    {
+        if(IsCoherent(sortKeys[rayIndex] >> 32, sortKeys[rayIndex - 1] >> 32))
+        {
+            statistics.coherentPairsAfterSort++;
+        }
+    }
+
+    // The next ray queue is free until the shade stage, gather the sorted rays into it
+    RayQueue &sortedRays = batch.nextRays;
+
+    ParallelFor(rays.size, [&](size_t begin, size_t end)
+    {
+        for(size_t rayIndex = begin; rayIndex < end; rayIndex++)
+        {
+            size_t sourceIndex = (size_t)(sortKeys[rayIndex] & 0xffffffff);
+
+            sortedRays.Set(rayIndex, Vector3(rays.originX[sourceIndex], rays.originY[sourceIndex], rays.originZ[sourceIndex]),
+                                     Vector3(rays.directionX[sourceIndex], rays.directionY[sourceIndex], rays.directionZ[sourceIndex]),
+                                     rays.GetThroughput(sourceIndex), rays.pathIndex[sourceIndex],
+                                     rays.GetEmissionWeight(sourceIndex), rays.bouncePdf[sourceIndex], rays.GetBounceNormal(sourceIndex));
+        }
+    });
+
+    sortedRays.size = rays.size;
+    std::swap(batch.rays, batch.nextRays);
+
+    statistics.sortSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - sortStart).count();
+}
+
+void WavefrontRenderer::ExtendStage(WavefrontBatch &batch)
+{
+    const RayQueue &rays = batch.rays;
+    HitQueue &hits = batch.hits;
+
+    ParallelFor(rays.size, [&](size_t begin, size_t end)
+    {
+        for(size_t rayIndex = begin; rayIndex < end; rayIndex++)
+        {
+            float t = 0.f, beta = 0.f, gamma = 0.f;
+            Vector3 n;
+            const ObjectBase *object = nullptr;
+
+            if(!mainScene->SingleRayTrace(rays.GetRay(rayIndex), t, n, beta, gamma, &object))
+            {
+                object = nullptr;
+            }
+
+            hits.t[rayIndex] = t;
+            hits.normalX[rayIndex] = n.x;
+            hits.normalY[rayIndex] = n.y;
+            hits.normalZ[rayIndex] = n.z;
+            hits.beta[rayIndex] = beta;
+            hits.gamma[rayIndex] = gamma;
+            hits.object[rayIndex] = object;
+        }
+    });
+}
+
+void WavefrontRenderer::ShadeStage(WavefrontBatch &batch, unsigned int depth)
+{
+    const RayQueue &rays = batch.rays;
+    const HitQueue &hits = batch.hits;
+    RayQueue &nextRays = batch.nextRays;
+    ShadowQueue &shadows = batch.shadows;
+
+    size_t slotCount = Renderer::GetMaxSelectedLightCount();
+    bool continuePaths = depth + 1 < mainScene->maxRecursionDepth;
+
+    std::atomic<size_t> nextRayCount(0);
+
+    ParallelFor(rays.size, [&](size_t begin, size_t end)
+    {
+        for(size_t rayIndex = begin; rayIndex < end; rayIndex++)
+        {
+            unsigned int pathIndex = rays.pathIndex[rayIndex];
+            Vector3 throughput = rays.GetThroughput(rayIndex);
+            const ObjectBase *object = hits.object[rayIndex];
+
+            PathRandomScope randomScope(batch.randomStates[pathIndex]);
+
+            size_t shadowIndex = rayIndex * slotCount;
+            std::fill(shadows.active.begin() + shadowIndex, shadows.active.begin() + shadowIndex + slotCount, 0);
+
+            if(!object)
+            {
+                if(depth == 0)
+                {
+                    batch.radiance[pathIndex] += Vector3(mainScene->bgColor.r, mainScene->bgColor.g, mainScene->bgColor.b);
+                }
+                continue;
+            }
+
+            Ray ray = rays.GetRay(rayIndex);
+            Vector3 normal(hits.normalX[rayIndex], hits.normalY[rayIndex], hits.normalZ[rayIndex]);
+            Vector3 intersectionPoint = ray.e + ray.dir * hits.t[rayIndex];
+
+            if(const Light *hitLight = Renderer::GetEmitter(object))
+            {
+                float bouncePdf = rays.bouncePdf[rayIndex];
+
+                if(bouncePdf > 0.f)
+                {
+                    // The shade stage takes a single sample of every light it picks
+                    float lightPdf = hitLight->GetPdf(intersectionPoint, normal, ray.e) * Renderer::GetLightSelectionProbability(hitLight, ray.e, rays.GetBounceNormal(rayIndex));
+                    batch.radiance[pathIndex] += rays.GetEmissionWeight(rayIndex) * hitLight->intensity * Renderer::PowerHeuristic(bouncePdf, lightPdf);
+                }
+                else
+                {
+                    batch.radiance[pathIndex] += throughput * hitLight->intensity;
+                }
+                continue;
+            }
+
+            const ShaderInfo shaderInfo(ray, object, intersectionPoint, normal, hits.beta[rayIndex], hits.gamma[rayIndex]);
+            const Material *material = object->material;
+
+            Vector3 diffuseColor = material->diffuse;
+
+            if(object->texture)
+            {
+                Vector3 textureColor = object->GetTextureColorAt(intersectionPoint, shaderInfo.beta, shaderInfo.gamma);
+
+                if(object->texture->decalMode == DECAL_MODE::REPLACE_ALL)
+                {
+                    batch.radiance[pathIndex] += throughput * textureColor;
+                    continue;
+                }
+
+                textureColor /= object->texture->normalizer;
+                textureColor.Clamp(0.f, 1.f);
+
+                if(object->texture->decalMode == DECAL_MODE::REPLACE_KD)
+                {
+                    diffuseColor = textureColor;
+                }
+                else
+                {
+                    diffuseColor = (material->diffuse + textureColor) * 0.5f;
+                }
+            }
+
+            batch.radiance[pathIndex] += throughput * Renderer::CalculateAmbientShader(material->ambient, mainScene->ambientLight);
+
+            Vector3 wo = -ray.dir;
+
+            static thread_local std::vector<LightSelection> lightSelections;
+            Renderer::SelectLights(intersectionPoint + normal * INTERSECTION_TEST_EPSILON, normal, lightSelections);
+
+            // Direct lighting, the contributions are added in the accumulate stage if the light is visible
+            for(size_t slot = 0; slot < lightSelections.size(); slot++)
+            {
+                const LightSelection &selection = lightSelections[slot];
+                const Light *light = mainScene->lights[selection.lightIndex];
+
+                float u = RandomGenerator::GetRandomFloat();
+                float v = RandomGenerator::GetRandomFloat();
+
+                Vector3 lightNormal;
+                Vector3 lightPosition = light->SamplePosition(u, v, lightNormal);
+                Vector3 wi = -light->GetDirection(lightPosition, intersectionPoint);
+
+                Vector3 lightIntensity;
+                float lightPdf = light->GetPdf(lightPosition, lightNormal, intersectionPoint) * selection.probability;
+
+                if(lightPdf > 0.f)
+                {
+                    float bouncePdf = Renderer::GetContinuationPdf(material, diffuseColor, normal, wo, wi);
+                    lightIntensity = light->intensity * (Renderer::PowerHeuristic(lightPdf, bouncePdf) / lightPdf);
+                }
+                else if(light->IsEmissiveGeometry())
+                {
+                    // The sample is on the light's side turned away from the point
+                    continue;
+                }
+                else
+                {
+                    lightIntensity = light->GetIntensityAtPosition(lightPosition, intersectionPoint) / selection.probability;
+                }
+
+                Vector3 lightContribution = Renderer::CalculateSurfaceShader(shaderInfo, diffuseColor, wo, wi, lightIntensity);
+
+                lightContribution = lightContribution * throughput;
+
+                if(lightContribution.x > 0.f || lightContribution.y > 0.f || lightContribution.z > 0.f)
+                {
+                    shadows.Set(shadowIndex + slot, selection.lightIndex, intersectionPoint, lightPosition, lightContribution);
+                }
+            }
+
+            if(!continuePaths)
+            {
+                continue;
+            }
+
+            Vector3 origin, direction, weight;
+            float bouncePdf;
+
+            if(!Renderer::SampleContinuation(ray, intersectionPoint, normal, material, diffuseColor, origin, direction, weight, bouncePdf))
+            {
+                continue;
+            }
+
+            Vector3 emissionWeight = Vector3::ZeroVector;
+
+            if(bouncePdf > 0.f)
+            {
+                emissionWeight = throughput * Renderer::CalculateSurfaceShader(shaderInfo, diffuseColor, wo, direction, Vector3(1.f)) / bouncePdf;
+            }
+
+            Vector3 nextThroughput = throughput * weight;
+
+            if(nextThroughput.x <= 0.f && nextThroughput.y <= 0.f && nextThroughput.z <= 0.f)
+            {
+                continue;
+            }
+
+            float survivalProbability;
+
+            if(!Renderer::SurvivesRussianRoulette(depth, nextThroughput, survivalProbability))
+            {
+                continue;
+            }
+
+            size_t nextRayIndex = nextRayCount.fetch_add(1, std::memory_order_relaxed);
+            nextRays.Set(nextRayIndex, origin, direction, nextThroughput / survivalProbability, pathIndex, emissionWeight / survivalProbability, bouncePdf, normal);
+        }
+    });
+
+    nextRays.size = nextRayCount.load();
+}
+
+void WavefrontRenderer::ShadowStage(WavefrontBatch &batch)
+{
+    ShadowQueue &shadows = batch.shadows;
+
+    size_t slotCount = Renderer::GetMaxSelectedLightCount();
+    size_t rayCount = batch.rays.size;
+
+    // Traced slot by slot, so the rays towards the same light are processed together when every light has a slot
+    // The active rays are traced in packets, the sorted rays of a slot start close to each other and head the same way
+    ParallelFor(rayCount * slotCount, [&](size_t begin, size_t end)
+    {
+        Ray packetRays[RayPacket8::Width];
+        size_t packetShadowIndices[RayPacket8::Width];
+        int packetRayCount = 0;
+
+        for(size_t streamIndex = begin; streamIndex < end; streamIndex++)
+        {
+            size_t slot = streamIndex / rayCount;
+            size_t shadowIndex = (streamIndex % rayCount) * slotCount + slot;
+
+            if(shadows.active[shadowIndex])
+            {
+                const Light *light = mainScene->lights[shadows.lightIndex[shadowIndex]];
+
+                Vector3 position(shadows.positionX[shadowIndex], shadows.positionY[shadowIndex], shadows.positionZ[shadowIndex]);
+                Vector3 lightPosition(shadows.lightPositionX[shadowIndex], shadows.lightPositionY[shadowIndex], shadows.lightPositionZ[shadowIndex]);
+
+                packetRays[packetRayCount] = light->GetShadowRay(lightPosition, position);
+                packetShadowIndices[packetRayCount] = shadowIndex;
+                packetRayCount++;
+            }
+
+            if(packetRayCount == RayPacket8::Width || (packetRayCount > 0 && streamIndex + 1 == end))
+            {
+                int occludedBits = mainScene->OcclusionTrace(packetRays, packetRayCount);
+
+                for(int lane = 0; lane < packetRayCount; lane++)
+                {
+                    if((occludedBits >> lane) & 1)
+                    {
+                        shadows.active[packetShadowIndices[lane]] = 0;
+                    }
+                }
+
+                packetRayCount = 0;
+            }
+        }
+    });
+}
+
+void WavefrontRenderer::AccumulateStage(WavefrontBatch &batch)
+{
+    const RayQueue &rays = batch.rays;
+    const ShadowQueue &shadows = batch.shadows;
+
+    size_t slotCount = Renderer::GetMaxSelectedLightCount();
+
+    // Every ray belongs to a different path, so the paths can be updated without locking
+    ParallelFor(rays.size, [&](size_t begin, size_t end)
+    {
+        for(size_t rayIndex = begin; rayIndex < end; rayIndex++)
+        {
+            Vector3 &radiance = batch.radiance[rays.pathIndex[rayIndex]];
+
+            size_t shadowIndex = rayIndex * slotCount;
+            for(size_t slot = 0; slot < slotCount; slot++, shadowIndex++)
+            {
+                if(shadows.active[shadowIndex])
+                {
+                    radiance += Vector3(shadows.contributionR[shadowIndex], shadows.contributionG[shadowIndex], shadows.contributionB[shadowIndex]);
+                }
+            }
+        }
+    });
+}
+
+void WavefrontRenderer::ResolveStage(const WavefrontBatch &batch, unsigned int sampleCount, float *colorBuffer)
+{
+    size_t firstPixel = batch.firstPath / sampleCount;
+    size_t lastPixel = (batch.firstPath + batch.pathCount - 1) / sampleCount;
+    float oneOverSampleCount = 1.f / sampleCount;
+
+    // A pixel's samples may be split between two batches, so each batch adds its share
+    ParallelFor(lastPixel - firstPixel + 1, [&](size_t begin, size_t end)
+    {
+        for(size_t pixelIndex = firstPixel + begin; pixelIndex < firstPixel + end; pixelIndex++)
+        {
+            size_t firstSample = mathMax(pixelIndex * sampleCount, batch.firstPath);
+            size_t endSample = mathMin((pixelIndex + 1) * sampleCount, batch.firstPath + batch.pathCount);
+
+            Vector3 pixelColor = Vector3::ZeroVector;
+            for(size_t globalPathIndex = firstSample; globalPathIndex < endSample; globalPathIndex++)
+            {
+                pixelColor += batch.radiance[globalPathIndex - batch.firstPath];
+            }
+
+            colorBuffer[pixelIndex * 3    ] += pixelColor.x * oneOverSampleCount;
+            colorBuffer[pixelIndex * 3 + 1] += pixelColor.y * oneOverSampleCount;
+            colorBuffer[pixelIndex * 3 + 2] += pixelColor.z * oneOverSampleCount;
+        }
+    });
+}
+
+void WavefrontRenderer::ParallelFor(size_t count, const std::function<void(size_t, size_t)> &function)
+{
+    // A few chunks per thread keep the threads busy when some chunks take longer than the others
+    size_t chunkCount = ThreadPool::GetThreadCount() * 4;
+    size_t grainSize = mathMax((count + chunkCount - 1) / chunkCount, (size_t)WAVEFRONT_MIN_PARALLEL_COUNT);
+
+    ThreadPool::ParallelFor(count, grainSize, function);
+}
@@ -0,0 +1,216 @@
+/*
+ *	Advanced ray-tracer algorithm
+ *	Emre Baris Coskun
+ *	2018
+ */
+
+#ifndef __WAVEFRONTRENDERER_H__
+#define __WAVEFRONTRENDERER_H__
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Camera.h"
+#include "Math.h"
+#include "RandomGenerator.h"
+#include "Ray.h"
+
+class ObjectBase;
+struct RendererInfo;
+
+/*
+    Structure of arrays ray queue
+    Holds one ray for every path that is still alive in the batch
+*/
+struct RayQueue
+{
+    void Resize(size_t capacity);
+
+    inline Ray GetRay(size_t index) const
+    {
+        return Ray(Vector3(originX[index], originY[index], originZ[index]), Vector3(directionX[index], directionY[index], directionZ[index]));
+    }
+
+    inline Vector3 GetThroughput(size_t index) const
+    {
+        return Vector3(throughputR[index], throughputG[index], throughputB[index]);
+    }
+
+    inline Vector3 GetEmissionWeight(size_t index) const
+    {
+        return Vector3(emissionWeightR[index], emissionWeightG[index], emissionWeightB[index]);
+    }
+
+    inline Vector3 GetBounceNormal(size_t index) const
+    {
+        return Vector3(bounceNormalX[index], bounceNormalY[index], bounceNormalZ[index]);
+    }
+
+    inline void Set(size_t index, const Vector3 &origin, const Vector3 &direction, const Vector3 &throughput, unsigned int path, const Vector3 &emissionWeight = Vector3::ZeroVector, float pdf = 0.f, const Vector3 &normal = Vector3::ZeroVector)
+    {
+        originX[index] = origin.x;
+        originY[index] = origin.y;
+        originZ[index] = origin.z;
+
+        directionX[index] = direction.x;
+        directionY[index] = direction.y;
+        directionZ[index] = direction.z;
+
+        throughputR[index] = throughput.x;
+        throughputG[index] = throughput.y;
+        throughputB[index] = throughput.z;
+
+        emissionWeightR[index] = emissionWeight.x;
+        emissionWeightG[index] = emissionWeight.y;
+        emissionWeightB[index] = emissionWeight.z;
+
+        bouncePdf[index] = pdf;
+
+        bounceNormalX[index] = normal.x;
+        bounceNormalY[index] = normal.y;
+        bounceNormalZ[index] = normal.z;
+
+        pathIndex[index] = path;
+    }
+
+    std::vector<float> originX, originY, originZ;
+    std::vector<float> directionX, directionY, directionZ;
+    std::vector<float> throughputR, throughputG, throughputB;
+
+    // Throughput of a light the ray hits and the density the ray was sampled with, 0 when light sampling cannot find the hit
+    std::vector<float> emissionWeightR, emissionWeightG, emissionWeightB;
+    std::vector<float> bouncePdf;
+
+    // Normal of the vertex the ray left from, the light BVH weighs the lights with it
+    std::vector<float> bounceNormalX, bounceNormalY, bounceNormalZ;
+
+    std::vector<unsigned int> pathIndex;
+
+    size_t size = 0;
+};
+
+/*
+    Structure of arrays hit queue
+    Entry i is the closest hit of the ray i in the ray queue, object is null on a miss
+*/
+struct HitQueue
+{
+    void Resize(size_t capacity);
+
+    std::vector<float> t;
+    std::vector<float> normalX, normalY, normalZ;
+    std::vector<float> beta, gamma;
+    std::vector<const ObjectBase *> object;
+};
+
+/*
+    Structure of arrays shadow ray queue
+    Entry (rayIndex * slotCount + slot) holds the shadow ray of the ray towards the light it picked for the slot
+    Every light has a slot of its own unless the scene samples the lights from its light BVH
+*/
+struct ShadowQueue
+{
+    void Resize(size_t capacity);
+
+    inline void Set(size_t index, unsigned int light, const Vector3 &position, const Vector3 &lightPosition, const Vector3 &contribution)
+    {
+        lightIndex[index] = light;
+
+        positionX[index] = position.x;
+        positionY[index] = position.y;
+        positionZ[index] = position.z;
+
+        lightPositionX[index] = lightPosition.x;
+        lightPositionY[index] = lightPosition.y;
+        lightPositionZ[index] = lightPosition.z;
+
+        contributionR[index] = contribution.x;
+        contributionG[index] = contribution.y;
+        contributionB[index] = contribution.z;
+
+        active[index] = 1;
+    }
+
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> lightPositionX, lightPositionY, lightPositionZ;
+    std::vector<float> contributionR, contributionG, contributionB;
+    std::vector<unsigned int> lightIndex;
+
+    // Cleared when there is nothing to add or the shadow ray is occluded
+    std::vector<unsigned char> active;
+};
+
+/*
+    Queues and per path accumulators of the batch being rendered
+*/
+struct WavefrontBatch
+{
+    RayQueue rays;
+    RayQueue nextRays;
+    HitQueue hits;
+    ShadowQueue shadows;
+
+    std::vector<Vector3> radiance;
+
+    // Random generator state of every path, loaded into the generator of the thread shading the path
+    std::vector<SampleState> randomStates;
+
+    // (Morton key << 32 | ray index) pairs used to reorder secondary rays
+    std::vector<uint64_t> sortKeys;
+
+    size_t firstPath = 0;
+    size_t pathCount = 0;
+};
+
+/*
+    Secondary ray coherence and timing figures of an image
+    Coherent pairs are neighbouring rays in the queue sharing the direction octant and origin cell
+*/
+struct WavefrontStatistics
+{
+    size_t secondaryRayCount = 0;
+    size_t coherentPairsBeforeSort = 0;
+    size_t coherentPairsAfterSort = 0;
+
+    double sortSeconds = 0.0;
+    double secondaryExtendSeconds = 0.0;
+};
+
+/*
+    Static wavefront path tracer
+    Processes a batch of paths stage by stage instead of recursing per pixel
+*/
+class WavefrontRenderer
+{
+public:
+    // Renders the camera's image into colorBuffer
+    static void RenderImage(const Camera *camera, int imageWidth, int imageHeight, float *colorBuffer);
+
+private:
+    // Creates the camera rays of the batch's paths
+    static void GenerateStage(WavefrontBatch &batch, const RendererInfo &ri, int imageWidth, unsigned int sampleCount);
+
+    // Reorders the secondary rays by direction octant and origin Morton code
+    static void SortStage(WavefrontBatch &batch, WavefrontStatistics &statistics);
+
+    // Finds the closest hit of every ray in the queue
+    static void ExtendStage(WavefrontBatch &batch);
+
+    // Evaluates emission and direct lighting, queues shadow rays and continuation rays
+    static void ShadeStage(WavefrontBatch &batch, unsigned int depth);
+
+    // Tests the queued shadow rays for occlusion
+    static void ShadowStage(WavefrontBatch &batch);
+
+    // Adds the unoccluded light contributions to the paths
+    static void AccumulateStage(WavefrontBatch &batch);
+
+    // Averages the batch's path radiances into the pixels they belong to
+    static void ResolveStage(const WavefrontBatch &batch, unsigned int sampleCount, float *colorBuffer);
+
+    // Splits [0, count) into chunks and runs them on the thread pool
+    static void ParallelFor(size_t count, const std::function<void(size_t, size_t)> &function);
+};
+
+#endif